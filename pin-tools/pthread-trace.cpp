@@ -2,6 +2,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iostream>
 
@@ -50,6 +51,31 @@ struct threadData {
    * The trace file to output to.
    */
   FILE *trace;
+
+  /**
+   * The array index of the trylock or timed call that the thread is in, whose outcome is not known yet.
+   */
+  UINT32 pendingIndex;
+
+  /**
+   * The synchronization object of the pending call.
+   */
+  ADDRINT pendingVariable;
+
+  /**
+   * The mutex of a pending pthread_cond_timedwait call.
+   */
+  ADDRINT pendingMutex;
+
+  /**
+   * The number of instructions executed by the thread before the pending call.
+   */
+  UINT64 pendingInstructionCount;
+
+  /**
+   * The timeout (in nanoseconds) of a pending timed call.
+   */
+  UINT64 pendingTimeout;
 };
 
 /**
@@ -83,6 +109,75 @@ VOID DumpToTrace(THREADID const threadId, UINT32 const index, ADDRINT const vari
     data->instructionCount);
 }
 
+/**
+ * Compute the time left until the absolute timeout of a timed call.
+ *
+ * @param abstime The address of the timespec passed to the call.
+ * @return The timeout in nanoseconds, or 0 if it has already passed.
+ */
+UINT64 TimeoutFrom(ADDRINT const abstime)
+{
+  struct timespec deadline;
+  if(PIN_SafeCopy(&deadline, reinterpret_cast<VOID *>(abstime), sizeof(deadline)) != sizeof(deadline)) {
+    return 0;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  INT64 const remaining =
+      (deadline.tv_sec - now.tv_sec) * 1000000000LL + (deadline.tv_nsec - now.tv_nsec);
+
+  return remaining > 0 ? static_cast<UINT64>(remaining) : 0;
+}
+
+/**
+ * Remember a trylock or timed call until its outcome is known.
+ *
+ * @param threadId The thread identifier.
+ * @param index The array index to the function call from the events array.
+ * @param variable The memory address of the synchronization object.
+ * @param mutex The memory address of the mutex, for pthread_cond_timedwait.
+ * @param abstime The address of the absolute timeout, for timed calls.
+ */
+VOID PendingCall(THREADID const threadId, UINT32 const index, ADDRINT const variable,
+    ADDRINT const mutex, ADDRINT const abstime)
+{
+  threadData *data = GetThreadData(threadId);
+
+  data->pendingIndex = index;
+  data->pendingVariable = variable;
+  data->pendingMutex = mutex;
+  data->pendingInstructionCount = data->instructionCount;
+  data->pendingTimeout = abstime == 0 ? 0 : TimeoutFrom(abstime);
+}
+
+/**
+ * Write a trylock or timed call to the trace, followed by its return value.
+ *
+ * Timed calls are also followed by their timeout.
+ *
+ * @param threadId The thread identifier.
+ * @param result The value returned by the call.
+ */
+VOID PendingCallReturned(THREADID const threadId, ADDRINT const result)
+{
+  threadData *data = GetThreadData(threadId);
+  char const *call = events[data->pendingIndex];
+
+  if(strcmp(call, "pthread_cond_timedwait") == 0) {
+    fprintf(data->trace, "%d %s %lu %lu %lu %d %lu\n", threadId, call, data->pendingVariable,
+      data->pendingInstructionCount, data->pendingMutex, static_cast<int>(result),
+      data->pendingTimeout);
+  } else if(strstr(call, "timed") != NULL) {
+    fprintf(data->trace, "%d %s %lu %lu %d %lu\n", threadId, call, data->pendingVariable,
+      data->pendingInstructionCount, static_cast<int>(result), data->pendingTimeout);
+  } else {
+    fprintf(data->trace, "%d %s %lu %lu %d\n", threadId, call, data->pendingVariable,
+      data->pendingInstructionCount, static_cast<int>(result));
+  }
+}
+
 /**
  * Setup a thread that is about to be created.
  *
@@ -157,6 +252,27 @@ VOID ImageLoad(IMG const image, VOID *)
 
     RTN routine = RTN_FindByName(image, events[i]);
 
+    if(RTN_Valid(routine) && (strstr(events[i], "trylock") != NULL || strstr(events[i], "timed") != NULL)) {
+      // The outcome of these calls is only known once they return.
+      RTN_Open(routine);
+
+      if(strstr(events[i], "timed") != NULL) {
+        RTN_InsertCall(routine, IPOINT_BEFORE, AFUNPTR(PendingCall), IARG_THREAD_ID, IARG_UINT32, i,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 0, IARG_ADDRINT, 0, IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+            IARG_END);
+      } else {
+        RTN_InsertCall(routine, IPOINT_BEFORE, AFUNPTR(PendingCall), IARG_THREAD_ID, IARG_UINT32, i,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 0, IARG_ADDRINT, 0, IARG_ADDRINT, 0, IARG_END);
+      }
+
+      RTN_InsertCall(routine, IPOINT_AFTER, AFUNPTR(PendingCallReturned), IARG_THREAD_ID,
+          IARG_FUNCRET_EXITPOINT_VALUE, IARG_END);
+
+      RTN_Close(routine);
+
+      continue;
+    }
+
     if(RTN_Valid(routine)) {
       RTN_Open(routine);
 
@@ -181,8 +297,17 @@ VOID ImageLoad(IMG const image, VOID *)
   if(RTN_Valid(cond_timedwait_routine)) {
     RTN_Open(cond_timedwait_routine);
 
-    RTN_InsertCall(cond_timedwait_routine, IPOINT_BEFORE, AFUNPTR(CondWait), IARG_THREAD_ID,
-        IARG_FUNCARG_ENTRYPOINT_VALUE, 0, IARG_FUNCARG_ENTRYPOINT_VALUE, 1, IARG_END);
+    UINT32 index = 0;
+    while(strcmp(events[index], "pthread_cond_timedwait") != 0) {
+      ++index;
+    }
+
+    RTN_InsertCall(cond_timedwait_routine, IPOINT_BEFORE, AFUNPTR(PendingCall), IARG_THREAD_ID,
+        IARG_UINT32, index, IARG_FUNCARG_ENTRYPOINT_VALUE, 0, IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+        IARG_FUNCARG_ENTRYPOINT_VALUE, 2, IARG_END);
+
+    RTN_InsertCall(cond_timedwait_routine, IPOINT_AFTER, AFUNPTR(PendingCallReturned),
+        IARG_THREAD_ID, IARG_FUNCRET_EXITPOINT_VALUE, IARG_END);
 
     RTN_Close(cond_timedwait_routine);
   }
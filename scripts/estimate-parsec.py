@@ -23,7 +23,7 @@ def fix_time_file(file):
         time_file.write(line)
 
 
-def run_rhythm(rhythm_exe, vtune_data, trace_file, output_dir, benchmark, thread_count, input_set):
+def run_rhythm(rhythm_exe, vtune_data, trace_file, output_dir, benchmark, thread_count, input_set, cpi_phases):
     run_id = datetime.now().strftime("%Y-%m-%d-%H-%M-%S")
     output_dir = os.path.join(output_dir, "{}".format(run_id))
 
@@ -31,7 +31,11 @@ def run_rhythm(rhythm_exe, vtune_data, trace_file, output_dir, benchmark, thread
     os.makedirs(output_dir, exist_ok=False)
 
     config_file = os.path.join(output_dir, "arch-config.json")
-    rhythm.create_architecture_config(vtune_data, config_file)
+    cpi_phases_file = None
+    if cpi_phases:
+        cpi_phases_file = os.path.join(vtune_data["path"], "vtune-hotspots-sliced.csv")
+
+    rhythm.create_architecture_config(vtune_data, config_file, cpi_phases_file)
     print("Generated architectural configuration.")
 
     with open(os.path.join(output_dir, "lscpu.txt"), 'w') as cpu_info_file:
@@ -70,6 +74,8 @@ def main():
     p.add_argument('-x', '--executable', dest='executable', default=None)
     p.add_argument('-b', '--benchmark', dest='benchmark', default=None)
     p.add_argument('-t', '--thread-count', dest='thread_count', default=None, type=int)
+    p.add_argument('-p', '--cpi-phases', dest='cpi_phases', action='store_true',
+                   help="Vary CPI rates by phase, using a time-sliced VTune CSV (vtune-hotspots-sliced.csv).")
 
     (args) = p.parse_args()
 
@@ -108,7 +114,8 @@ def main():
         trace_file = rhythm.find_matching_trace(database, config)
         print("Using trace: {}".format(trace_file))
 
-        run_rhythm(args.executable, config, trace_file, args.output_dir, benchmark, thread_count, config["input-set"])
+        run_rhythm(args.executable, config, trace_file, args.output_dir, benchmark, thread_count, config["input-set"],
+                   args.cpi_phases)
 
 
 if __name__ == "__main__":
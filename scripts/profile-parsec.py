@@ -5,13 +5,14 @@ import subprocess
 import sys
 import os
 import json
+import time
 
 from datetime import datetime
 from rhythm import parsec
 from rhythm import vtune
 
 
-def run_benchmark(analysis, output_dir, benchmark, input_set, thread_count):
+def run_benchmark(analysis, output_dir, benchmark, input_set, thread_count, slice_length):
     vtune_exe = vtune.find_vtune()
 
     run_id = datetime.now().strftime("%Y-%m-%d-%H-%M-%S")
@@ -27,7 +28,9 @@ def run_benchmark(analysis, output_dir, benchmark, input_set, thread_count):
     vtune_command = "{} -c {} -data-limit=0 -r {} --".format(vtune_exe, analysis, vtune_dir)
 
     with open(os.path.join(output_dir, "parsec.out"), 'w') as parsec_out_file:
+        start = time.monotonic()
         parsec.run_benchmark(parsec_out_file, "gcc-pthreads", benchmark, input_set, thread_count, vtune_command)
+        duration = time.monotonic() - start
 
     with open(os.path.join(output_dir, "config.json"), 'w') as config_file:
         data = {
@@ -36,7 +39,8 @@ def run_benchmark(analysis, output_dir, benchmark, input_set, thread_count):
             'vtune-analysis': analysis,
             'benchmark': benchmark,
             'input-set': input_set,
-            'thread-count': thread_count
+            'thread-count': thread_count,
+            'slice-length': slice_length
         }
 
         json.dump(data, config_file, indent=2)
@@ -44,6 +48,11 @@ def run_benchmark(analysis, output_dir, benchmark, input_set, thread_count):
     vtune.generate_report(vtune_exe, "hotspots", vtune_dir, os.path.join(output_dir, "vtune-hotspots.csv"))
     vtune.generate_report(vtune_exe, "hw-events", vtune_dir, os.path.join(output_dir, "vtune-hw-events.csv"))
 
+    # The run is timed from outside the collection, so the last slices may be empty.
+    if slice_length is not None:
+        vtune.generate_sliced_report(vtune_exe, "hotspots", vtune_dir,
+                                     os.path.join(output_dir, "vtune-hotspots-sliced.csv"), duration, slice_length)
+
 
 def main():
     p = argparse.ArgumentParser(description="Profile the PARSEC benchmarks with Vtune.")
@@ -53,6 +62,8 @@ def main():
     p.add_argument('-b', '--benchmark', dest='benchmark', default="blackscholes")
     p.add_argument('-t', '--thread-count', dest="thread_count", default=4)
     p.add_argument('-r', '--run-count', dest="run_count", default=1, type=int)
+    p.add_argument('-s', '--slice-length', dest="slice_length", default=None, type=float,
+                   help="Also report the hotspots of each time slice of this many seconds (vtune-hotspots-sliced.csv).")
 
     (args) = p.parse_args()
 
@@ -74,7 +85,7 @@ def main():
         for benchmark in sorted(benchmarks):
             print("Run {} of {} for the {} benchmark.".format(run + 1, args.run_count, benchmark))
             run_benchmark(args.analysis_type, args.output_dir, benchmark, args.input_set,
-                          args.thread_count)
+                          args.thread_count, args.slice_length)
 
 
 if __name__ == "__main__":
@@ -63,7 +63,66 @@ def is_valid_thread(thread_name):
     return True
 
 
-def create_architecture_config(config, out):
+def merge_cpi_phases(slices, tolerance):
+    merged = []
+
+    for time_slice in slices:
+        if merged:
+            previous = merged[-1]
+
+            # Slices with a similar CPI rate belong to the same phase, whose CPI rate is weighted by instructions.
+            if abs(time_slice["cpi.rate"] - previous["cpi.rate"]) <= tolerance * previous["cpi.rate"]:
+                instructions = previous["instructions"] + time_slice["instructions"]
+                cycles = previous["cpi.rate"] * previous["instructions"] + \
+                    time_slice["cpi.rate"] * time_slice["instructions"]
+
+                previous["cpi.rate"] = cycles / instructions
+                previous["instructions"] = instructions
+                continue
+
+        merged.append(dict(time_slice))
+
+    return [{'start': phase["start"], 'cpi.rate': phase["cpi.rate"]} for phase in merged]
+
+
+def read_cpi_phases(data_file, tolerance=0.1):
+    if not os.path.exists(data_file):
+        sys.exit("Error: could not find {}".format(data_file))
+
+    slices = {}
+
+    # Each row is one time slice of one thread, in time order.
+    with open(data_file, 'r') as csv_file:
+        reader = csv.DictReader(csv_file)
+
+        for row in reader:
+            if not is_valid_thread(row["Thread"]):
+                continue
+
+            thread_id = int(row["TID"])
+            instructions = int(float(row["Instructions Retired"]))
+            cpi_rate = float(row["CPI Rate"])
+
+            if thread_id not in slices:
+                slices[thread_id] = {'retired': 0, 'phases': []}
+
+            thread_slices = slices[thread_id]
+            if instructions > 0:
+                thread_slices["phases"].append(
+                    {'start': thread_slices["retired"], 'instructions': instructions, 'cpi.rate': cpi_rate})
+                thread_slices["retired"] = thread_slices["retired"] + instructions
+
+    cpi_phases = {}
+    for thread_id, thread_slices in slices.items():
+        cpi_phases[thread_id] = {
+            'index': "instructions",
+            'rates': merge_cpi_phases(thread_slices["phases"], tolerance)
+        }
+
+    return cpi_phases
+
+
+def create_architecture_config(config, out, cpi_phases_file=None):
     data_file = os.path.join(config["path"], "vtune-hotspots.csv")
 
     if not os.path.exists(data_file):
@@ -106,13 +165,22 @@ def create_architecture_config(config, out):
         }
     }
 
+    cpi_phases = {}
+    if cpi_phases_file is not None:
+        cpi_phases = read_cpi_phases(cpi_phases_file)
+
     # Populate the skeleton with TIDs and CPI rates.
     new_tid = 0
     for key in sorted(core_type_data.keys()):
-        arch_config["architecture"]["core.types"][0]["threads"].append({
+        thread = {
             'tid': new_tid,
             'cpi.rate': core_type_data[key]["cpi.rate"]
-        })
+        }
+
+        if key in cpi_phases:
+            thread["cpi.phases"] = cpi_phases[key]
+
+        arch_config["architecture"]["core.types"][0]["threads"].append(thread)
 
         arch_config["system"]["static.frequencies"].append({
             'tid': new_tid,
@@ -1,3 +1,5 @@
+import csv
+import math
 import subprocess
 import sys
 import os
@@ -20,3 +22,37 @@ def generate_report(vtune, report_type, data_dir, output_file):
         .format(vtune, report_type, data_dir, output_file)
 
     subprocess.run(vtune_command.split())
+
+
+def generate_sliced_report(vtune, report_type, data_dir, output_file, duration, slice_length):
+    # Each slice of the collection is reported on its own, so the rows of each thread end up in time order.
+    header = None
+    rows = []
+
+    for index in range(int(math.ceil(duration / slice_length))):
+        begin = index * slice_length
+        end = min(begin + slice_length, duration)
+        slice_file = "{}.{}".format(output_file, index)
+
+        vtune_command = "{} -format=csv -csv-delimiter=comma -group-by=thread -R {} -r={} -time-filter={:.3f}:{:.3f} " \
+                        "-report-output={}".format(vtune, report_type, data_dir, begin, end, slice_file)
+        subprocess.run(vtune_command.split())
+
+        # Slices without samples have no report.
+        if not os.path.exists(slice_file):
+            continue
+
+        with open(slice_file, 'r') as csv_file:
+            reader = csv.reader(csv_file)
+            header = next(reader, header)
+            rows.extend(reader)
+
+        os.remove(slice_file)
+
+    if header is None:
+        sys.exit("Error: no time slice of {} could be reported.".format(data_dir))
+
+    with open(output_file, 'w', newline='') as csv_file:
+        writer = csv.writer(csv_file)
+        writer.writerow(header)
+        writer.writerows(rows)
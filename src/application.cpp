@@ -1,40 +1,188 @@
 #include "application.hpp"
 
 #include <cassert>
+#include <stdexcept>
 
 namespace rhythm {
 
+namespace {
+
+// The lowest bits of an event header hold the event type, the remaining bits hold the distance.
+constexpr unsigned TYPE_BITS = 8;
+
+constexpr std::uint64_t TYPE_MASK = (std::uint64_t{1} << TYPE_BITS) - 1;
+
+constexpr icount_t MAX_DISTANCE = std::numeric_limits<std::uint64_t>::max() >> TYPE_BITS;
+
+bool has_target_thread(event_t type)
+{
+  return type == event_t::thread_create || type == event_t::thread_join;
+}
+
+bool has_mutex(event_t type)
+{
+  return type == event_t::condition_wait || type == event_t::condition_timeout;
+}
+
+bool has_timeout(event_t type)
+{
+  return type == event_t::condition_timeout || type == event_t::lock_timeout || type == event_t::rwlock_timeout;
+}
+
+} // namespace
+
+object_t intern(object_table &table, address_t address)
+{
+  auto const id = static_cast<object_t>(table.addresses.size());
+
+  auto const emplaced = table.ids.emplace(address, id);
+  if(emplaced.second) {
+    table.addresses.push_back(address);
+  }
+
+  return emplaced.first->second;
+}
+
+object_t find(object_table const &table, address_t address)
+{
+  auto const it = table.ids.find(address);
+  assert(it != table.ids.end());
+
+  return it->second;
+}
+
+application_thread &get_thread(app_m &app, thread_t thread_id)
+{
+  while(app.threads.size() <= thread_index(thread_id)) {
+    app.threads.emplace_back(static_cast<thread_t>(app.threads.size()));
+  }
+
+  return app.threads[thread_index(thread_id)];
+}
+
 void add_event(application_thread &tm, event_m event)
 {
   assert(event.type != event_t::unknown);
+  assert(event.thread_id == tm.id);
+
+  if(event.distance > MAX_DISTANCE) {
+    throw std::runtime_error("The distance between two events is too large to be represented.");
+  }
+
+  tm.headers.push_back(event.distance << TYPE_BITS | static_cast<std::uint64_t>(event.type));
 
-  tm.events.push_back(event);
+  if(has_target_thread(event.type)) {
+    assert(event.target_thread >= 0 && event.target_thread <= std::numeric_limits<std::uint32_t>::max());
+    tm.operands.push_back(static_cast<std::uint32_t>(event.target_thread));
+  } else {
+    tm.operands.push_back(event.object);
+  }
+
+  if(has_mutex(event.type)) {
+    tm.mutexes.push_back(event.object2);
+  }
+
+  if(has_timeout(event.type)) {
+    tm.timeouts.push_back(event.timeout);
+  }
+}
+
+std::size_t event_count(application_thread const &tm, thread_cursor const &cursor)
+{
+  return tm.headers.size() - cursor.next;
 }
 
-void pop_current_event(application_thread &tm)
+void refill(application_thread &tm)
 {
-  assert(!tm.events.empty());
+  if(!tm.source) {
+    return;
+  }
+
+  tm.headers.clear();
+  tm.operands.clear();
+  tm.mutexes.clear();
+  tm.timeouts.clear();
+
+  event_m event;
+  while(tm.headers.size() < tm.window) {
+    if(!tm.source(event)) {
+      // Release the trace, the thread has no more events.
+      tm.source = nullptr;
+      break;
+    }
 
-  tm.events.pop_front();
+    add_event(tm, event);
+  }
 }
 
-event_m get_current_event(application_thread const &tm)
+void pop_current_event(application_thread &tm, thread_cursor &cursor)
 {
-  assert(!tm.events.empty());
+  assert(event_count(tm, cursor) > 0);
+
+  std::uint64_t const header = tm.headers[cursor.next];
+  auto const type = static_cast<event_t>(header & TYPE_MASK);
+  if(has_mutex(type)) {
+    cursor.next_mutex++;
+  } else if(type == event_t::barrier_wait) {
+    cursor.barriers++;
+  }
+
+  if(has_timeout(type)) {
+    cursor.next_timeout++;
+  }
+
+  cursor.next++;
+  cursor.progress = 0;
+  cursor.retired += header >> TYPE_BITS;
 
-  return tm.events.front();
+  if(event_count(tm, cursor) == 0 && tm.source) {
+    // Reuse the columns from the start for the next window of events.
+    refill(tm);
+    cursor.next = 0;
+    cursor.next_mutex = 0;
+    cursor.next_timeout = 0;
+  }
 }
 
-void execute(application_thread &tm, icount_t instructions)
+event_m get_current_event(application_thread const &tm, thread_cursor const &cursor)
 {
-  assert(!tm.events.empty());
+  assert(event_count(tm, cursor) > 0);
+
+  std::uint64_t const header = tm.headers[cursor.next];
 
-  if(tm.events.front().distance >= instructions) {
-    tm.events.front().distance -= instructions;
+  event_m event;
+
+  event.thread_id = tm.id;
+  event.type = static_cast<event_t>(header & TYPE_MASK);
+  event.distance = (header >> TYPE_BITS) - cursor.progress;
+
+  if(has_target_thread(event.type)) {
+    event.target_thread = tm.operands[cursor.next];
   } else {
-    // Due to floating point, estimating instructions from time can cause some off-by-a-little errors so we ensure that
-    // the instruction count remains non-negative.
-    tm.events.front().distance = 0;
+    event.object = tm.operands[cursor.next];
+  }
+
+  if(has_mutex(event.type)) {
+    assert(cursor.next_mutex < tm.mutexes.size());
+    event.object2 = tm.mutexes[cursor.next_mutex];
   }
+
+  if(has_timeout(event.type)) {
+    assert(cursor.next_timeout < tm.timeouts.size());
+    event.timeout = tm.timeouts[cursor.next_timeout];
+  }
+
+  return event;
+}
+
+void execute(application_thread const &tm, thread_cursor &cursor, icount_t instructions)
+{
+  assert(event_count(tm, cursor) > 0);
+  assert(get_current_event(tm, cursor).distance >= instructions);
+
+  // The thread model is only checked in debug builds.
+  (void)tm;
+
+  cursor.progress += instructions;
 }
 } // namespace rhythm
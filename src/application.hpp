@@ -1,8 +1,12 @@
 #ifndef RHYTHM_APPLICATION_HPP
 #define RHYTHM_APPLICATION_HPP
 
-#include <deque>
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "common.hpp"
 
@@ -10,12 +14,57 @@
 
 namespace rhythm {
 
+/**
+ * Produces the events of a thread on demand.
+ *
+ * @return False once the thread has no more events.
+ */
+using event_source = std::function<bool(event_m &event)>;
+
 /**
  * Represents a thread as a sequence of events separated by dynamic instruction counts.
+ *
+ * Events are stored as columns. The owning thread is implicit, the type and distance of an event are packed into
+ * a single word, and only condition_wait and condition_timeout events store a second object (out-of-line, in order), as
+ * timeout events do with their timeouts.
+ *
+ * The position of an estimation within the events is kept separately, in a thread_cursor. Thread models that are
+ * not streamed are never modified by an estimation, so they can be shared by concurrent estimations.
  */
 struct application_thread {
   thread_t id;
-  std::deque<event_m> events;
+
+  /**
+   * The distance and type of each event, packed as (distance << 8 | type).
+   */
+  std::vector<std::uint64_t> headers;
+
+  /**
+   * The object ID of each event, or the target thread for thread_create and thread_join events.
+   */
+  std::vector<std::uint32_t> operands;
+
+  /**
+   * The mutex of each condition_wait and condition_timeout event.
+   */
+  std::vector<object_t> mutexes;
+
+  /**
+   * The timeout of each timeout event.
+   */
+  std::vector<time_t> timeouts;
+
+  /**
+   * Where further events are read from when the thread is streamed from its trace.
+   *
+   * Empty if all events of the thread are held in memory.
+   */
+  event_source source;
+
+  /**
+   * The maximum number of events to hold in memory when the thread is streamed from its trace.
+   */
+  std::size_t window = 0;
 
   /**
    * Constructor.
@@ -25,41 +74,161 @@ struct application_thread {
   }
 };
 
+/**
+ * The position of an estimation within the events of a thread.
+ */
+struct thread_cursor {
+  /**
+   * The index of the current event.
+   */
+  std::size_t next = 0;
+
+  /**
+   * The index of the mutex for the next condition_wait or condition_timeout event.
+   */
+  std::size_t next_mutex = 0;
+
+  /**
+   * The index of the timeout for the next timeout event.
+   */
+  std::size_t next_timeout = 0;
+
+  /**
+   * The instructions already executed towards the current event.
+   */
+  icount_t progress = 0;
+
+  /**
+   * The instructions executed towards all previous events.
+   */
+  icount_t retired = 0;
+
+  /**
+   * The number of barriers passed.
+   */
+  std::uint64_t barriers = 0;
+
+  /**
+   * The CPI phase that the thread was last found in, where the next lookup starts from.
+   */
+  std::size_t phase = 0;
+};
+
+/**
+ * Dense IDs for the addresses of one kind of synchronization object.
+ */
+struct object_table {
+  /**
+   * The address of each object, indexed by ID.
+   */
+  std::vector<address_t> addresses;
+
+  /**
+   * The ID of each address.
+   */
+  std::unordered_map<address_t, object_t> ids;
+};
+
+/**
+ * The synchronization objects found in a trace.
+ */
+struct object_tables {
+  object_table barriers;
+  object_table condition_variables;
+  object_table locks;
+  object_table rwlocks;
+};
+
+/**
+ * @return The ID of an address, assigning the next ID if the address has not been seen before.
+ */
+object_t intern(object_table &table, address_t address);
+
+/**
+ * @return The ID of an address that has already been interned.
+ */
+object_t find(object_table const &table, address_t address);
+
 /**
  * Represents an application as a collection of threads.
  */
 struct app_m {
-  std::map<thread_t, application_thread> threads;
+  /**
+   * The threads of the application, indexed by thread ID.
+   */
+  std::vector<application_thread> threads;
+
+  /**
+   * The synchronization objects acted on by the threads.
+   *
+   * Shared with the event sources of streamed threads.
+   */
+  std::shared_ptr<object_tables> objects = std::make_shared<object_tables>();
 };
 
+/**
+ * The position of an estimation within the events of every thread of an application.
+ */
+struct app_cursor {
+  /**
+   * The cursor of each thread, indexed by thread ID.
+   */
+  std::vector<thread_cursor> threads;
+
+  /**
+   * Constructor, positions every thread at its first event.
+   */
+  explicit app_cursor(app_m const &app) : threads(app.threads.size())
+  {
+  }
+};
+
+/**
+ * @return The thread model with the given ID, creating it (and any thread with a lower ID) if needed.
+ */
+application_thread &get_thread(app_m &app, thread_t thread_id);
+
 /**
  * Add a synchronization event to the thread model.
  */
 void add_event(application_thread &tm, event_m event);
 
+/**
+ * @return The number of events that have not been removed from the thread model.
+ */
+std::size_t event_count(application_thread const &tm, thread_cursor const &cursor);
+
+/**
+ * Stream events of the thread model from its source, up to its window size.
+ *
+ * All events in memory are replaced, so this should only be done once they have all been removed.
+ */
+void refill(application_thread &tm);
+
 /**
  * Remove the current event from the thread model.
  *
- * This should only be done when the current event no longer has instructions to execute.
+ * This should only be done when the current event no longer has instructions to execute. Streamed thread models
+ * are refilled from their source once all events in memory have been removed.
  */
-void pop_current_event(application_thread &tm);
+void pop_current_event(application_thread &tm, thread_cursor &cursor);
 
 /**
  * @return The next synchronization event.
  */
-event_m get_current_event(application_thread const &tm);
+event_m get_current_event(application_thread const &tm, thread_cursor const &cursor);
 
 /**
  * Progress the thread by executing instructions.
  */
-void execute(application_thread &tm, icount_t instructions);
+void execute(application_thread const &tm, thread_cursor &cursor, icount_t instructions);
 
 template <typename ostream>
 ostream &operator<<(ostream &os, application_thread const &tm)
 {
   os << "[thread_model] ";
   os << "ID: " << tm.id << ", ";
-  os << "Events: " << tm.events.size();
+  os << "Events: " << tm.headers.size();
 
   return os;
 }
@@ -68,7 +237,10 @@ template <typename ostream>
 ostream &operator<<(ostream &os, app_m const &am)
 {
   os << "[application_model] ";
-  os << "Threads: " << am.threads.size();
+  os << "Threads: " << am.threads.size() << ", ";
+  os << "Barriers: " << am.objects->barriers.addresses.size() << ", ";
+  os << "Condition Variables: " << am.objects->condition_variables.addresses.size() << ", ";
+  os << "Locks: " << am.objects->locks.addresses.size();
 
   return os;
 }
@@ -2,11 +2,234 @@
 
 #include <cassert>
 #include <fstream>
+#include <stdexcept>
+#include <string>
 
 #include "json.hpp"
 
 namespace rhythm {
 
+phase_index to_phase_index(std::string const &name)
+{
+  if(name == "instructions") {
+    return phase_index::instructions;
+  } else if(name == "barriers") {
+    return phase_index::barriers;
+  }
+
+  throw std::runtime_error("Unknown CPI phase index: " + name);
+}
+
+cpi_series parse_cpi_phases(nlohmann::json const &phases_config)
+{
+  cpi_series series{};
+
+  series.index = to_phase_index(phases_config.value("index", std::string("instructions")));
+
+  for(auto const &phase : phases_config["rates"]) {
+    std::uint64_t const start = phase["start"];
+    cpi_t const cpi_rate = phase["cpi.rate"];
+
+    if(cpi_rate <= 0) {
+      throw std::runtime_error("CPI phases must have a positive cpi.rate.");
+    }
+
+    if(!series.phases.empty() && start <= series.phases.back().start) {
+      throw std::runtime_error("CPI phases must be in increasing order of start.");
+    }
+
+    series.phases.push_back(cpi_phase{start, cpi_rate});
+  }
+
+  return series;
+}
+
+topology_t parse_topology(nlohmann::json const &topology_config, std::size_t core_count)
+{
+  topology_t topology{};
+
+  topology.threads_per_core = topology_config.value("threads.per.core", std::size_t(1));
+  if(topology.threads_per_core == 0 || core_count % topology.threads_per_core != 0) {
+    throw std::runtime_error("The number of cores must be a positive multiple of threads.per.core.");
+  }
+
+  topology.cores_per_socket = topology_config.value("cores.per.socket", std::size_t(0));
+
+  topology.smt_slowdown = topology_config.value("smt.slowdown", 1.0);
+  if(topology.smt_slowdown < 1) {
+    throw std::runtime_error("The smt.slowdown must be at least one.");
+  }
+
+  if(topology_config.count("remote.latency") > 0) {
+    std::int64_t const remote_latency = topology_config["remote.latency"];
+    if(remote_latency < 0) {
+      throw std::runtime_error("The remote.latency must not be a negative number of nanoseconds.");
+    }
+
+    topology.remote_latency = time_t(remote_latency);
+  }
+
+  return topology;
+}
+
+memory_t parse_memory(nlohmann::json const &memory_config)
+{
+  memory_t memory{};
+
+  memory.bandwidth = memory_config["bandwidth"];
+  if(memory.bandwidth <= 0) {
+    throw std::runtime_error("The memory bandwidth must be a positive number of bytes per second.");
+  }
+
+  for(auto const &thread : memory_config["threads"]) {
+    thread_t const thread_id = thread["tid"];
+    double const bytes_per_instruction = thread["bytes.per.instruction"];
+
+    if(thread_index(thread_id) >= memory.bytes_per_instruction.size()) {
+      memory.bytes_per_instruction.resize(thread_index(thread_id) + 1, 0);
+    }
+
+    memory.bytes_per_instruction[thread_id] = bytes_per_instruction;
+  }
+
+  return memory;
+}
+
+governor_policy to_governor_policy(std::string const &name)
+{
+  if(name == "static") {
+    return governor_policy::static_levels;
+  } else if(name == "race-to-idle") {
+    return governor_policy::race_to_idle;
+  } else if(name == "budget") {
+    return governor_policy::budget;
+  } else if(name == "lock-aware") {
+    return governor_policy::lock_aware;
+  }
+
+  throw std::runtime_error("Unknown frequency governor: " + name);
+}
+
+governor_t parse_governor(nlohmann::json const &system)
+{
+  governor_t governor{};
+
+  if(system.count("static.frequencies") > 0) {
+    for(auto const &thread : system["static.frequencies"]) {
+      thread_t const thread_id = thread["tid"];
+      std::size_t const level = thread["level"];
+
+      if(thread_index(thread_id) >= governor.static_levels.size()) {
+        governor.static_levels.resize(thread_index(thread_id) + 1, 0);
+      }
+
+      governor.static_levels[thread_id] = level;
+    }
+  }
+
+  governor.policy = to_governor_policy(system.value("governor", std::string("static")));
+
+  if(governor.policy == governor_policy::budget) {
+    if(system.count("frequency.budget") == 0) {
+      throw std::runtime_error("The budget frequency governor requires a frequency.budget.");
+    }
+
+    governor.budget = system["frequency.budget"];
+  }
+
+  return governor;
+}
+
+scheduler_policy to_scheduler_policy(std::string const &name)
+{
+  if(name == "fifo") {
+    return scheduler_policy::fifo;
+  } else if(name == "round-robin") {
+    return scheduler_policy::round_robin;
+  } else if(name == "fair") {
+    return scheduler_policy::fair;
+  } else if(name == "heterogeneous") {
+    return scheduler_policy::heterogeneous;
+  }
+
+  throw std::runtime_error("Unknown scheduler: " + name);
+}
+
+scheduler_t parse_scheduler(nlohmann::json const &system)
+{
+  scheduler_t scheduler{};
+
+  scheduler.policy = to_scheduler_policy(system.value("scheduler", std::string("fifo")));
+
+  if(system.count("time.slice") > 0) {
+    std::int64_t const time_slice = system["time.slice"];
+    if(time_slice <= 0) {
+      throw std::runtime_error("The time.slice must be a positive number of nanoseconds.");
+    }
+
+    scheduler.time_slice = time_t(time_slice);
+  } else if(scheduler.policy == scheduler_policy::round_robin || scheduler.policy == scheduler_policy::fair) {
+    throw std::runtime_error("The round-robin and fair schedulers require a time.slice.");
+  }
+
+  if(system.count("context.switch") > 0) {
+    std::int64_t const context_switch = system["context.switch"];
+    if(context_switch < 0) {
+      throw std::runtime_error("The context.switch must not be a negative number of nanoseconds.");
+    }
+
+    scheduler.context_switch = time_t(context_switch);
+  }
+
+  if(system.count("migration.penalty") > 0) {
+    std::int64_t const migration_penalty = system["migration.penalty"];
+    if(migration_penalty < 0) {
+      throw std::runtime_error("The migration.penalty must not be a negative number of cycles.");
+    }
+
+    scheduler.migration_penalty = static_cast<std::uint64_t>(migration_penalty);
+  }
+
+  return scheduler;
+}
+
+rwlock_policy to_rwlock_policy(std::string const &name)
+{
+  if(name == "reader") {
+    return rwlock_policy::reader_preferring;
+  } else if(name == "writer") {
+    return rwlock_policy::writer_preferring;
+  } else if(name == "fair") {
+    return rwlock_policy::fair;
+  }
+
+  throw std::runtime_error("Unknown reader/writer lock preference: " + name);
+}
+
+time_t parse_cost(nlohmann::json const &costs_config, std::string const &name)
+{
+  std::int64_t const cost = costs_config.value(name, std::int64_t(0));
+  if(cost < 0) {
+    throw std::runtime_error("The " + name + " cost must not be a negative number of nanoseconds.");
+  }
+
+  return time_t(cost);
+}
+
+sync_costs_t parse_sync_costs(nlohmann::json const &costs_config)
+{
+  sync_costs_t costs{};
+
+  costs.lock_acquire = parse_cost(costs_config, "lock.acquire");
+  costs.lock_hand_off = parse_cost(costs_config, "lock.hand.off");
+  costs.barrier_arrival = parse_cost(costs_config, "barrier.arrival");
+  costs.barrier_release = parse_cost(costs_config, "barrier.release");
+  costs.thread_create = parse_cost(costs_config, "thread.create");
+  costs.wake_up = parse_cost(costs_config, "wake.up");
+
+  return costs;
+}
+
 arch_m parse_config_file(std::string const &file)
 {
   auto stream = std::ifstream(file);
@@ -14,18 +237,62 @@ arch_m parse_config_file(std::string const &file)
 
   arch_m arch{};
 
+  // Objects are dumped with their keys in order, so the hash does not depend on the formatting of the file.
+  std::string const config = input.dump();
+  arch.config_hash = hash_bytes(config.data(), config.size());
+
   for(auto const &core_type_config : input["architecture"]["core.types"]) {
     core_t new_core_type{};
 
     for(auto const &thread : core_type_config["threads"]) {
       thread_t const thread_id = thread["tid"];
-      cpi_t const cpi_rate = thread["cpi.rate"];
 
-      new_core_type.cpi_rates.emplace(thread_id, cpi_rate);
+      cpi_series phases{};
+      if(thread.count("cpi.phases") > 0) {
+        phases = parse_cpi_phases(thread["cpi.phases"]);
+      }
+
+      cpi_t cpi_rate = 0;
+      if(thread.count("cpi.rate") > 0) {
+        cpi_rate = thread["cpi.rate"];
+      } else if(!phases.phases.empty() && phases.phases.front().start == 0) {
+        // The thread runs at its first phase from the start.
+        cpi_rate = phases.phases.front().cpi_rate;
+      } else {
+        throw std::runtime_error("Thread " + std::to_string(thread_id) +
+            " needs a cpi.rate, unless its first CPI phase starts at 0.");
+      }
+
+      if(thread_index(thread_id) >= new_core_type.cpi_rates.size()) {
+        new_core_type.cpi_rates.resize(thread_index(thread_id) + 1, 0);
+      }
+
+      new_core_type.cpi_rates[thread_id] = cpi_rate;
+
+      if(!phases.phases.empty()) {
+        if(thread_index(thread_id) >= new_core_type.cpi_phases.size()) {
+          new_core_type.cpi_phases.resize(thread_index(thread_id) + 1);
+        }
+
+        new_core_type.cpi_phases[thread_id] = std::move(phases);
+      }
+    }
+
+    for(auto const &level : core_type_config["frequency.levels"]) {
+      std::size_t const level_id = level["id"];
+      freq_t const frequency = level["frequency"];
+
+      if(level_id >= new_core_type.frequencies.size()) {
+        new_core_type.frequencies.resize(level_id + 1, 0);
+      }
+
+      new_core_type.frequencies[level_id] = frequency;
     }
 
-    for(auto const &level: core_type_config["frequency.levels"]) {
-      new_core_type.frequencies.push_back(level["frequency"]);
+    for(auto const frequency : new_core_type.frequencies) {
+      if(frequency <= 0) {
+        throw std::runtime_error("Frequency levels must be numbered from zero without gaps.");
+      }
     }
 
     std::string const core_type_id = core_type_config["id"];
@@ -37,6 +304,32 @@ arch_m parse_config_file(std::string const &file)
     arch.cores.emplace_back(arch.core_types.at(core_type_id));
   }
 
+  if(input["architecture"].count("topology") > 0) {
+    arch.topology = parse_topology(input["architecture"]["topology"], arch.cores.size());
+  }
+
+  if(input["architecture"].count("memory") > 0) {
+    arch.memory = parse_memory(input["architecture"]["memory"]);
+  }
+
+  if(input.count("system") > 0) {
+    arch.governor = parse_governor(input["system"]);
+    arch.scheduler = parse_scheduler(input["system"]);
+
+    if(input["system"].count("synchronization.costs") > 0) {
+      arch.sync_costs = parse_sync_costs(input["system"]["synchronization.costs"]);
+    }
+
+    arch.rwlock_preference = to_rwlock_policy(input["system"].value("rwlock.preference", std::string("reader")));
+
+    std::int64_t const spin_window = input["system"].value("spin.window", std::int64_t(0));
+    if(spin_window < 0) {
+      throw std::runtime_error("The spin.window must not be a negative number of nanoseconds.");
+    }
+
+    arch.spin_window = time_t(spin_window);
+  }
+
   return arch;
 }
 
@@ -10,17 +10,58 @@
 
 namespace rhythm {
 
+/**
+ * How the progress of a thread through its CPI phases is measured.
+ */
+enum class phase_index {
+  /**
+   * By the number of instructions the thread has executed.
+   */
+  instructions,
+  /**
+   * By the number of barriers the thread has passed.
+   */
+  barriers,
+};
+
+/**
+ * A CPI rate that a thread runs at from a point in its progress onwards.
+ */
+struct cpi_phase {
+  std::uint64_t start;
+
+  cpi_t cpi_rate;
+};
+
+/**
+ * The CPI rates that a thread runs at as it progresses, in order of start.
+ */
+struct cpi_series {
+  phase_index index = phase_index::instructions;
+
+  std::vector<cpi_phase> phases;
+};
+
 /**
  * Represents a core type that can be found in a multiprocessor.
  */
 struct core_t {
   /**
-   * The CPI rate that a thread can run at on this type of core.
+   * The CPI rate that a thread can run at on this type of core, indexed by thread ID.
+   *
+   * Threads without a CPI rate for this type of core have a rate of zero.
+   */
+  std::vector<cpi_t> cpi_rates;
+
+  /**
+   * The CPI phases of each thread on this type of core, indexed by thread ID.
+   *
+   * Before its first phase, or without any phases, a thread runs at its CPI rate.
    */
-  std::map<thread_t, cpi_t> cpi_rates;
+  std::vector<cpi_series> cpi_phases;
 
   /**
-   * The available frequencies that this type of core can operate at.
+   * The available frequencies that this type of core can operate at, indexed by frequency level.
    */
   std::vector<freq_t> frequencies;
 };
@@ -32,7 +73,7 @@ struct core_m {
   /**
    * Create a core based on the core type and set its initial frequency to the first available frequency level.
    */
-  explicit core_m(core_t const &t) : type(t), frequency(t.frequencies.at(0))
+  explicit core_m(core_t const &t) : type(t), level(0), frequency(t.frequencies.at(0))
   {
   }
 
@@ -41,12 +82,209 @@ struct core_m {
    */
   core_t const &type;
 
+  /**
+   * The frequency level that this core is operating at.
+   */
+  std::size_t level;
+
   /**
    * The frequency that this core is operating at.
    */
   freq_t frequency;
 };
 
+/**
+ * The policies that a frequency governor can follow.
+ */
+enum class governor_policy {
+  /**
+   * A core runs at the static frequency level of the thread running on it.
+   */
+  static_levels,
+  /**
+   * A core runs at its highest frequency while it runs a thread, and at its lowest frequency while it is idle.
+   */
+  race_to_idle,
+  /**
+   * The frequencies of all busy cores share a fixed budget, each busy core runs at the highest frequency within its
+   * share. Idle cores run at their lowest frequency.
+   */
+  budget,
+  /**
+   * Like static_levels, except that threads holding a lock that other threads wait for run at the highest frequency
+   * to shorten the critical section.
+   */
+  lock_aware,
+};
+
+/**
+ * Decides the frequency of each core as threads are scheduled.
+ */
+struct governor_t {
+  governor_policy policy = governor_policy::static_levels;
+
+  /**
+   * The frequency level of each thread under static_levels, indexed by thread ID.
+   *
+   * Threads without a static frequency level run at level zero.
+   */
+  std::vector<std::size_t> static_levels;
+
+  /**
+   * The sum of the frequencies of all busy cores under the budget policy.
+   */
+  freq_t budget = 0;
+};
+
+/**
+ * The policies that the operating system scheduler can follow.
+ */
+enum class scheduler_policy {
+  /**
+   * Threads run in the order they became runnable, on the core that has been idle the longest.
+   */
+  fifo,
+  /**
+   * Like fifo, except that threads always have a time slice.
+   */
+  round_robin,
+  /**
+   * The waiting thread that has spent the least time running runs next, threads always have a time slice.
+   */
+  fair,
+  /**
+   * Like fifo, except that each thread runs on the idle core that gets it to its next event the soonest, based on its
+   * CPI rate on the type of the core, the highest frequency of the core and the cost of migrating to the core.
+   */
+  heterogeneous,
+};
+
+/**
+ * Decides which runnable thread runs next and on which core.
+ *
+ * With a time slice, a running thread whose time slice expires goes back to the run queue if the policy prefers a
+ * waiting thread. Under every policy except fair, any waiting thread is preferred.
+ */
+struct scheduler_t {
+  scheduler_policy policy = scheduler_policy::fifo;
+
+  /**
+   * How long a thread runs before it can be preempted, or zero if threads are never preempted.
+   */
+  time_t time_slice{0};
+
+  /**
+   * How long a core takes to switch to a thread before the thread starts to progress.
+   */
+  time_t context_switch{0};
+
+  /**
+   * How many cycles a thread stalls for when it runs on a different core than it last ran on, while it warms up the
+   * caches of its new core.
+   */
+  std::uint64_t migration_penalty = 0;
+};
+
+/**
+ * Which threads a reader/writer lock prefers when both readers and writers wait for it.
+ */
+enum class rwlock_policy {
+  /**
+   * Readers acquire the lock whenever no writer holds it, even if writers are waiting.
+   */
+  reader_preferring,
+  /**
+   * Readers do not acquire the lock while a writer is waiting, and waiting writers acquire it before waiting readers.
+   */
+  writer_preferring,
+  /**
+   * Threads acquire the lock in order of arrival, with consecutive readers acquiring it together.
+   */
+  fair,
+};
+
+/**
+ * The time that the synchronization primitives of the thread library and operating system take, beyond the
+ * instructions between events in the trace.
+ */
+struct sync_costs_t {
+  /**
+   * How long a thread takes to acquire a lock that no other thread holds.
+   */
+  time_t lock_acquire{0};
+
+  /**
+   * How long a thread waiting for a lock takes to run after the lock is handed to it.
+   */
+  time_t lock_hand_off{0};
+
+  /**
+   * How long each thread that arrives at a barrier adds to the release of the barrier.
+   */
+  time_t barrier_arrival{0};
+
+  /**
+   * How long a barrier takes to release its threads, besides the arrivals.
+   */
+  time_t barrier_release{0};
+
+  /**
+   * How long a thread takes to create another thread, which cannot start before then.
+   */
+  time_t thread_create{0};
+
+  /**
+   * How long any other thread that is woken up, for example by a condition variable, takes to run.
+   */
+  time_t wake_up{0};
+};
+
+/**
+ * Groups the cores of a multiprocessor into physical cores and sockets.
+ *
+ * Each core is a hardware thread, consecutive cores share a physical core and consecutive physical cores share a
+ * socket. Each socket is a NUMA node.
+ */
+struct topology_t {
+  /**
+   * The number of hardware threads in each physical core, which is one without SMT.
+   */
+  std::size_t threads_per_core = 1;
+
+  /**
+   * The number of physical cores in each socket, or zero if all cores share a single socket.
+   */
+  std::size_t cores_per_socket = 0;
+
+  /**
+   * The factor by which the CPI of a thread inflates while another hardware thread of its physical core is busy.
+   */
+  double smt_slowdown = 1.0;
+
+  /**
+   * How much longer a lock hand-off or barrier wake-up takes to reach a thread on another socket, which is its own
+   * NUMA node.
+   */
+  time_t remote_latency{0};
+};
+
+/**
+ * Models the memory bandwidth that threads running on the same socket share.
+ */
+struct memory_t {
+  /**
+   * The memory bandwidth available to each socket in bytes per second, or zero if bandwidth is unlimited.
+   */
+  double bandwidth = 0;
+
+  /**
+   * The bytes each thread transfers from memory per instruction, indexed by thread ID.
+   *
+   * Threads without a figure do not access memory.
+   */
+  std::vector<double> bytes_per_instruction;
+};
+
 /**
  * Models a multiprocessor as a collection of cores, where each core has a certain type.
  */
@@ -60,6 +298,46 @@ struct arch_m {
    * The physical or virtual cores found in this multiprocessor.
    */
   std::vector<core_m> cores;
+
+  /**
+   * How the cores are grouped into physical cores and sockets.
+   */
+  topology_t topology;
+
+  /**
+   * The memory bandwidth shared by the cores.
+   */
+  memory_t memory;
+
+  /**
+   * The frequency governor of the system.
+   */
+  governor_t governor;
+
+  /**
+   * The scheduler of the system.
+   */
+  scheduler_t scheduler;
+
+  /**
+   * The cost of synchronization.
+   */
+  sync_costs_t sync_costs;
+
+  /**
+   * The policy of reader/writer locks.
+   */
+  rwlock_policy rwlock_preference = rwlock_policy::reader_preferring;
+
+  /**
+   * How long a thread that finds a mutex held spins on its core before it blocks, or zero if it blocks right away.
+   */
+  time_t spin_window{0};
+
+  /**
+   * A hash of the configuration this architecture was parsed from, which identifies it in checkpoints.
+   */
+  std::uint64_t config_hash = EMPTY_HASH;
 };
 
 /**
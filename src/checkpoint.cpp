@@ -0,0 +1,814 @@
+#include "checkpoint.hpp"
+
+#include <array>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace rhythm {
+
+namespace {
+
+constexpr char CHECKPOINT_MAGIC[8] = {'R', 'H', 'Y', 'T', 'H', 'M', 'C', 'P'};
+
+// Bump the version whenever the layout of a released checkpoint changes.
+constexpr std::uint32_t CHECKPOINT_VERSION = 12;
+
+// Times and rates are written as they are held in memory, which depends on the arithmetic the build converts them with.
+#ifdef RHYTHM_FIXED_POINT_TIME
+constexpr std::uint8_t TIME_REPRESENTATION = 1;
+#else
+constexpr std::uint8_t TIME_REPRESENTATION = 0;
+#endif
+
+// Values are written in the byte order of the machine, like the binary trace format. Containers are written as
+// their number of elements followed by each element.
+
+template <typename T>
+using if_scalar = typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type;
+
+template <typename T, typename = if_scalar<T>>
+void write(std::ostream &out, T value);
+void write(std::ostream &out, time_t const &time);
+void write(std::ostream &out, event_m const &event);
+void write(std::ostream &out, thread_set const &threads);
+void write(std::ostream &out, kernel_thread const &thread);
+void write(std::ostream &out, barrier_m const &barrier);
+void write(std::ostream &out, condition_variable_m const &cv);
+void write(std::ostream &out, lock_m const &lock);
+void write(std::ostream &out, rwlock_waiter const &waiter);
+void write(std::ostream &out, rwlock_m const &rwlock);
+void write(std::ostream &out, sync_m const &sm);
+void write(std::ostream &out, runqueue_entry const &entry);
+void write(std::ostream &out, sched_thread const &thread);
+void write(std::ostream &out, sched_m const &sched);
+void write(std::ostream &out, timeline_event const &event);
+void write(std::ostream &out, timeline_thread const &thread);
+void write(std::ostream &out, timeline_m const &tl);
+void write(std::ostream &out, thread_cursor const &cursor);
+void write(std::ostream &out, status_tracker const &tracker);
+void write(std::ostream &out, sync_tracker const &tracker);
+void write(std::ostream &out, stats_t const &stats);
+template <typename T>
+void write(std::ostream &out, std::vector<T> const &values);
+template <typename T>
+void write(std::ostream &out, std::deque<T> const &values);
+template <typename T>
+void write(std::ostream &out, std::set<T> const &values);
+template <typename T>
+void write(std::ostream &out, std::multiset<T> const &values);
+template <typename K, typename V>
+void write(std::ostream &out, std::map<K, V> const &values);
+template <typename T, std::size_t N>
+void write(std::ostream &out, std::array<T, N> const &values);
+
+template <typename T, typename = if_scalar<T>>
+void read(std::istream &in, T &value);
+void read(std::istream &in, time_t &time);
+void read(std::istream &in, event_m &event);
+void read(std::istream &in, thread_set &threads);
+void read(std::istream &in, std::vector<kernel_thread> &threads);
+void read(std::istream &in, barrier_m &barrier);
+void read(std::istream &in, condition_variable_m &cv);
+void read(std::istream &in, lock_m &lock);
+void read(std::istream &in, rwlock_waiter &waiter);
+void read(std::istream &in, rwlock_m &rwlock);
+void read(std::istream &in, sync_m &sm);
+void read(std::istream &in, runqueue_entry &entry);
+void read(std::istream &in, sched_thread &thread);
+void read(std::istream &in, sched_m &sched);
+void read(std::istream &in, timeline_event &event);
+void read(std::istream &in, timeline_thread &thread);
+void read(std::istream &in, timeline_m &tl);
+void read(std::istream &in, thread_cursor &cursor);
+void read(std::istream &in, status_tracker &tracker);
+void read(std::istream &in, sync_tracker &tracker);
+void read(std::istream &in, stats_t &stats);
+template <typename T>
+void read(std::istream &in, std::vector<T> &values);
+template <typename T>
+void read(std::istream &in, std::deque<T> &values);
+template <typename T>
+void read(std::istream &in, std::set<T> &values);
+template <typename T>
+void read(std::istream &in, std::multiset<T> &values);
+template <typename K, typename V>
+void read(std::istream &in, std::map<K, V> &values);
+template <typename T, std::size_t N>
+void read(std::istream &in, std::array<T, N> &values);
+
+template <typename T, typename>
+void write(std::ostream &out, T value)
+{
+  out.write(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+template <typename T, typename>
+void read(std::istream &in, T &value)
+{
+  in.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+void write_size(std::ostream &out, std::size_t size)
+{
+  write(out, static_cast<std::uint64_t>(size));
+}
+
+std::size_t read_size(std::istream &in)
+{
+  std::uint64_t size = 0;
+  read(in, size);
+
+  if(!in) {
+    throw std::runtime_error("The checkpoint is truncated.");
+  }
+
+  return static_cast<std::size_t>(size);
+}
+
+template <typename T>
+void write(std::ostream &out, std::vector<T> const &values)
+{
+  write_size(out, values.size());
+  for(auto const &value : values) {
+    write(out, value);
+  }
+}
+
+template <typename T>
+void read(std::istream &in, std::vector<T> &values)
+{
+  values.resize(read_size(in));
+  for(auto &value : values) {
+    read(in, value);
+  }
+}
+
+template <typename T>
+void write(std::ostream &out, std::deque<T> const &values)
+{
+  write_size(out, values.size());
+  for(auto const &value : values) {
+    write(out, value);
+  }
+}
+
+template <typename T>
+void read(std::istream &in, std::deque<T> &values)
+{
+  values.resize(read_size(in));
+  for(auto &value : values) {
+    read(in, value);
+  }
+}
+
+template <typename T>
+void write(std::ostream &out, std::set<T> const &values)
+{
+  write_size(out, values.size());
+  for(auto const &value : values) {
+    write(out, value);
+  }
+}
+
+template <typename T>
+void read(std::istream &in, std::set<T> &values)
+{
+  values.clear();
+
+  auto const size = read_size(in);
+  for(std::size_t i = 0; i < size; ++i) {
+    T value{};
+    read(in, value);
+    values.insert(value);
+  }
+}
+
+template <typename T>
+void write(std::ostream &out, std::multiset<T> const &values)
+{
+  write_size(out, values.size());
+  for(auto const &value : values) {
+    write(out, value);
+  }
+}
+
+template <typename T>
+void read(std::istream &in, std::multiset<T> &values)
+{
+  values.clear();
+
+  auto const size = read_size(in);
+  for(std::size_t i = 0; i < size; ++i) {
+    T value{};
+    read(in, value);
+    values.insert(value);
+  }
+}
+
+template <typename K, typename V>
+void write(std::ostream &out, std::map<K, V> const &values)
+{
+  write_size(out, values.size());
+  for(auto const &pair : values) {
+    write(out, pair.first);
+    write(out, pair.second);
+  }
+}
+
+template <typename K, typename V>
+void read(std::istream &in, std::map<K, V> &values)
+{
+  values.clear();
+
+  auto const size = read_size(in);
+  for(std::size_t i = 0; i < size; ++i) {
+    K key{};
+    read(in, key);
+    read(in, values[key]);
+  }
+}
+
+template <typename T, std::size_t N>
+void write(std::ostream &out, std::array<T, N> const &values)
+{
+  for(auto const &value : values) {
+    write(out, value);
+  }
+}
+
+template <typename T, std::size_t N>
+void read(std::istream &in, std::array<T, N> &values)
+{
+  for(auto &value : values) {
+    read(in, value);
+  }
+}
+
+void write(std::ostream &out, time_t const &time)
+{
+  write(out, time.count());
+}
+
+void read(std::istream &in, time_t &time)
+{
+  time_t::rep count = 0;
+  read(in, count);
+
+  time = time_t(count);
+}
+
+void write(std::ostream &out, event_m const &event)
+{
+  write(out, event.thread_id);
+  write(out, event.type);
+  write(out, event.distance);
+  write(out, event.object);
+  write(out, event.object2);
+  write(out, event.target_thread);
+  write(out, event.timeout);
+}
+
+void read(std::istream &in, event_m &event)
+{
+  read(in, event.thread_id);
+  read(in, event.type);
+  read(in, event.distance);
+  read(in, event.object);
+  read(in, event.object2);
+  read(in, event.target_thread);
+  read(in, event.timeout);
+}
+
+void write(std::ostream &out, thread_set const &threads)
+{
+  write_size(out, threads.size());
+  for(auto const thread_id : threads) {
+    write(out, thread_id);
+  }
+}
+
+void read(std::istream &in, thread_set &threads)
+{
+  threads.clear();
+
+  auto const size = read_size(in);
+  for(std::size_t i = 0; i < size; ++i) {
+    thread_t thread_id = INVALID_THREAD_ID;
+    read(in, thread_id);
+    threads.insert(thread_id);
+  }
+}
+
+void write(std::ostream &out, kernel_thread const &thread)
+{
+  write(out, thread.id);
+  write(out, thread.status);
+  write(out, thread.locks_held);
+  write(out, thread.rwlocks_held);
+  write(out, thread.timed_mutex);
+  write(out, thread.safety_net);
+}
+
+void read(std::istream &in, std::vector<kernel_thread> &threads)
+{
+  threads.clear();
+
+  auto const size = read_size(in);
+  for(std::size_t i = 0; i < size; ++i) {
+    thread_t thread_id = INVALID_THREAD_ID;
+    read(in, thread_id);
+
+    threads.emplace_back(thread_id);
+    read(in, threads.back().status);
+    read(in, threads.back().locks_held);
+    read(in, threads.back().rwlocks_held);
+    read(in, threads.back().timed_mutex);
+    read(in, threads.back().safety_net);
+  }
+}
+
+void write(std::ostream &out, barrier_m const &barrier)
+{
+  write(out, barrier.count);
+  write(out, barrier.waiters);
+}
+
+void read(std::istream &in, barrier_m &barrier)
+{
+  read(in, barrier.count);
+  read(in, barrier.waiters);
+}
+
+void write(std::ostream &out, condition_variable_m const &cv)
+{
+  write(out, cv.initialized);
+  write(out, cv.signallers);
+  write(out, cv.signal_count);
+  write(out, cv.broadcasters);
+  write(out, cv.broadcast_count);
+  write(out, cv.last_broadcaster);
+  write(out, cv.consumers);
+  write(out, cv.production);
+  write(out, cv.waiters);
+  write(out, cv.mutexes);
+}
+
+void read(std::istream &in, condition_variable_m &cv)
+{
+  read(in, cv.initialized);
+  read(in, cv.signallers);
+  read(in, cv.signal_count);
+  read(in, cv.broadcasters);
+  read(in, cv.broadcast_count);
+  read(in, cv.last_broadcaster);
+  read(in, cv.consumers);
+  read(in, cv.production);
+  read(in, cv.waiters);
+  read(in, cv.mutexes);
+}
+
+void write(std::ostream &out, lock_m const &lock)
+{
+  write(out, lock.initialized);
+  write(out, lock.spin);
+  write(out, lock.held_by);
+  write(out, lock.waiters);
+}
+
+void read(std::istream &in, lock_m &lock)
+{
+  read(in, lock.initialized);
+  read(in, lock.spin);
+  read(in, lock.held_by);
+  read(in, lock.waiters);
+}
+
+void write(std::ostream &out, rwlock_waiter const &waiter)
+{
+  write(out, waiter.thread_id);
+  write(out, waiter.writer);
+}
+
+void read(std::istream &in, rwlock_waiter &waiter)
+{
+  read(in, waiter.thread_id);
+  read(in, waiter.writer);
+}
+
+void write(std::ostream &out, rwlock_m const &rwlock)
+{
+  write(out, rwlock.initialized);
+  write(out, rwlock.readers);
+  write(out, rwlock.writer);
+  write(out, rwlock.waiters);
+}
+
+void read(std::istream &in, rwlock_m &rwlock)
+{
+  read(in, rwlock.initialized);
+  read(in, rwlock.readers);
+  read(in, rwlock.writer);
+  read(in, rwlock.waiters);
+}
+
+void write(std::ostream &out, sync_m const &sm)
+{
+  write(out, sm.threads);
+  write(out, sm.live_threads);
+  write(out, sm.finished_threads);
+  write(out, sm.blocked_threads);
+  write(out, sm.barriers);
+  write(out, sm.condition_variables);
+  write(out, sm.locks);
+  write(out, sm.rwlocks);
+  write(out, sm.join_queue);
+}
+
+void read(std::istream &in, sync_m &sm)
+{
+  read(in, sm.threads);
+  read(in, sm.live_threads);
+  read(in, sm.finished_threads);
+  read(in, sm.blocked_threads);
+  read(in, sm.barriers);
+  read(in, sm.condition_variables);
+  read(in, sm.locks);
+  read(in, sm.rwlocks);
+  read(in, sm.join_queue);
+}
+
+void write(std::ostream &out, runqueue_entry const &entry)
+{
+  write(out, entry.key);
+  write(out, entry.arrival);
+  write(out, entry.thread_id);
+}
+
+void read(std::istream &in, runqueue_entry &entry)
+{
+  read(in, entry.key);
+  read(in, entry.arrival);
+  read(in, entry.thread_id);
+}
+
+void write(std::ostream &out, sched_thread const &thread)
+{
+  write(out, thread.runtime);
+  write(out, thread.dispatched);
+  write(out, thread.last_core);
+  write(out, thread.ready);
+  write(out, thread.spinning);
+  write(out, thread.spin_end);
+}
+
+void read(std::istream &in, sched_thread &thread)
+{
+  read(in, thread.runtime);
+  read(in, thread.dispatched);
+  read(in, thread.last_core);
+  read(in, thread.ready);
+  read(in, thread.spinning);
+  read(in, thread.spin_end);
+}
+
+void write(std::ostream &out, sched_m const &sched)
+{
+  // Entries are ordered by key and arrival, so the order within the queue does not matter.
+  std::vector<runqueue_entry> runnable_threads;
+  for(auto queue = sched.runnable_threads; !queue.empty(); queue.pop()) {
+    runnable_threads.push_back(queue.top());
+  }
+
+  write(out, sched.running_threads);
+  write(out, runnable_threads);
+  write(out, sched.arrivals);
+  write(out, sched.min_runtime);
+  write(out, sched.threads);
+  write(out, sched.mapping);
+  write(out, sched.idle_cores);
+  write(out, sched.remapped_threads);
+  write(out, sched.slowdown);
+}
+
+void read(std::istream &in, sched_m &sched)
+{
+  std::vector<runqueue_entry> runnable_threads;
+
+  read(in, sched.running_threads);
+  read(in, runnable_threads);
+  read(in, sched.arrivals);
+  read(in, sched.min_runtime);
+  read(in, sched.threads);
+  read(in, sched.mapping);
+  read(in, sched.idle_cores);
+  read(in, sched.remapped_threads);
+  read(in, sched.slowdown);
+
+  sched.runnable_threads = decltype(sched.runnable_threads)();
+  for(auto const &entry : runnable_threads) {
+    sched.runnable_threads.push(entry);
+  }
+}
+
+void write(std::ostream &out, timeline_event const &event)
+{
+  write(out, event.time);
+  write(out, event.thread_id);
+  write(out, event.version);
+  write(out, event.expiry);
+  write(out, event.timer);
+}
+
+void read(std::istream &in, timeline_event &event)
+{
+  read(in, event.time);
+  read(in, event.thread_id);
+  read(in, event.version);
+  read(in, event.expiry);
+  read(in, event.timer);
+}
+
+void write(std::ostream &out, timeline_thread const &thread)
+{
+  write(out, thread.version);
+  write(out, thread.active);
+  write(out, thread.synced);
+  write(out, thread.rate);
+  write(out, thread.deadline);
+}
+
+void read(std::istream &in, timeline_thread &thread)
+{
+  read(in, thread.version);
+  read(in, thread.active);
+  read(in, thread.synced);
+  read(in, thread.rate);
+  read(in, thread.deadline);
+}
+
+void write(std::ostream &out, timeline_m const &tl)
+{
+  // The order of events within the queue does not matter, they are ordered again when read.
+  std::vector<timeline_event> events;
+  for(auto queue = tl.events; !queue.empty(); queue.pop()) {
+    events.push_back(queue.top());
+  }
+
+  std::vector<timeline_event> timers;
+  for(auto queue = tl.timers; !queue.empty(); queue.pop()) {
+    timers.push_back(queue.top());
+  }
+
+  write(out, tl.now);
+  write(out, events);
+  write(out, timers);
+  write(out, tl.threads);
+}
+
+void read(std::istream &in, timeline_m &tl)
+{
+  std::vector<timeline_event> events;
+  std::vector<timeline_event> timers;
+
+  read(in, tl.now);
+  read(in, events);
+  read(in, timers);
+  read(in, tl.threads);
+
+  tl.events = decltype(tl.events)();
+  for(auto const &event : events) {
+    tl.events.push(event);
+  }
+
+  tl.timers = decltype(tl.timers)();
+  for(auto const &timer : timers) {
+    tl.timers.push(timer);
+  }
+}
+
+void write(std::ostream &out, thread_cursor const &cursor)
+{
+  write(out, cursor.next);
+  write(out, cursor.next_mutex);
+  write(out, cursor.next_timeout);
+  write(out, cursor.progress);
+  write(out, cursor.retired);
+  write(out, cursor.barriers);
+  write(out, cursor.phase);
+}
+
+void read(std::istream &in, thread_cursor &cursor)
+{
+  read(in, cursor.next);
+  read(in, cursor.next_mutex);
+  read(in, cursor.next_timeout);
+  read(in, cursor.progress);
+  read(in, cursor.retired);
+  read(in, cursor.barriers);
+  read(in, cursor.phase);
+}
+
+void write(std::ostream &out, status_tracker const &tracker)
+{
+  write(out, tracker.times);
+}
+
+void read(std::istream &in, status_tracker &tracker)
+{
+  read(in, tracker.times);
+}
+
+void write(std::ostream &out, sync_tracker const &tracker)
+{
+  write(out, tracker.last_event);
+  write(out, tracker.lock_wait_times);
+  write(out, tracker.barrier_wait_times);
+  write(out, tracker.condition_wait_times);
+  write(out, tracker.rwlock_wait_times);
+  write(out, tracker.lock_remote_times);
+  write(out, tracker.barrier_remote_times);
+  write(out, tracker.rwlock_remote_times);
+}
+
+void read(std::istream &in, sync_tracker &tracker)
+{
+  read(in, tracker.last_event);
+  read(in, tracker.lock_wait_times);
+  read(in, tracker.barrier_wait_times);
+  read(in, tracker.condition_wait_times);
+  read(in, tracker.rwlock_wait_times);
+  read(in, tracker.lock_remote_times);
+  read(in, tracker.barrier_remote_times);
+  read(in, tracker.rwlock_remote_times);
+}
+
+void write(std::ostream &out, stats_t const &stats)
+{
+  write(out, stats.total_time);
+  write(out, stats.run_time);
+  write(out, stats.status_time);
+  write(out, stats.sync_time);
+  write(out, stats.frequency_residency);
+}
+
+void read(std::istream &in, stats_t &stats)
+{
+  read(in, stats.total_time);
+  read(in, stats.run_time);
+  read(in, stats.status_time);
+  read(in, stats.sync_time);
+  read(in, stats.frequency_residency);
+}
+
+template <typename T>
+std::uint64_t hash_values(std::vector<T> const &values, std::uint64_t hash)
+{
+  return hash_bytes(values.data(), values.size() * sizeof(T), hash);
+}
+
+/**
+ * @return A hash of the events of every thread, which identifies the traces of an application in checkpoints.
+ */
+std::uint64_t hash_application(app_m const &app)
+{
+  std::uint64_t hash = EMPTY_HASH;
+
+  for(auto const &thread : app.threads) {
+    std::uint64_t const count = thread.headers.size();
+
+    hash = hash_bytes(&count, sizeof(count), hash);
+    hash = hash_values(thread.headers, hash);
+    hash = hash_values(thread.operands, hash);
+    hash = hash_values(thread.mutexes, hash);
+
+    for(auto const &timeout : thread.timeouts) {
+      auto const nanoseconds = timeout.count();
+      hash = hash_bytes(&nanoseconds, sizeof(nanoseconds), hash);
+    }
+  }
+
+  return hash;
+}
+
+} // namespace
+
+void save_checkpoint(std::string const &file, app_m const &app, simulation_m const &sim, arch_m const &arch)
+{
+  std::ofstream out(file, std::ios::binary);
+  if(!out) {
+    throw std::runtime_error("Could not create checkpoint: " + file);
+  }
+
+  out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+  write(out, CHECKPOINT_VERSION);
+  write(out, TIME_REPRESENTATION);
+  write(out, arch.config_hash);
+  write(out, hash_application(app));
+
+  std::vector<std::size_t> levels;
+  for(auto const &core : arch.cores) {
+    levels.push_back(core.level);
+  }
+
+  write(out, levels);
+  write(out, sim.cursor.threads);
+  write(out, sim.sched);
+  write(out, sim.sm);
+  write(out, sim.tl);
+
+  // The residency that is not accounted for yet is saved as it stands now.
+  stats_t stats = sim.stats;
+  flush_residency(stats, sim.tl.now);
+  write(out, stats);
+
+  if(!out) {
+    throw std::runtime_error("Could not write checkpoint: " + file);
+  }
+}
+
+simulation_m load_checkpoint(std::string const &file, app_m const &app, arch_m &arch)
+{
+  std::ifstream in(file, std::ios::binary);
+  if(!in) {
+    throw std::runtime_error("Could not open checkpoint: " + file);
+  }
+
+  char magic[sizeof(CHECKPOINT_MAGIC)] = {};
+  std::uint32_t version = 0;
+
+  in.read(magic, sizeof(magic));
+  read(in, version);
+
+  if(!in || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+    throw std::runtime_error("Not a checkpoint: " + file);
+  }
+
+  if(version != CHECKPOINT_VERSION) {
+    throw std::runtime_error("Unsupported checkpoint version: " + std::to_string(version));
+  }
+
+  std::uint8_t time_representation = 0;
+  read(in, time_representation);
+
+  if(time_representation != TIME_REPRESENTATION) {
+    throw std::runtime_error("The checkpoint was saved with a different time arithmetic (RHYTHM_FIXED_POINT_TIME).");
+  }
+
+  std::uint64_t config_hash = 0;
+  std::uint64_t app_hash = 0;
+
+  read(in, config_hash);
+  read(in, app_hash);
+
+  if(config_hash != arch.config_hash) {
+    throw std::runtime_error("The checkpoint was saved with a different configuration.");
+  }
+
+  if(app_hash != hash_application(app)) {
+    throw std::runtime_error("The checkpoint was saved with a different application.");
+  }
+
+  std::vector<std::size_t> levels;
+  read(in, levels);
+
+  if(levels.size() != arch.cores.size()) {
+    throw std::runtime_error("The checkpoint was saved with a different number of cores.");
+  }
+
+  simulation_m sim{app_cursor(app), sched_m{}, sync_m{}, timeline_m{}, stats_t{}};
+
+  read(in, sim.cursor.threads);
+  if(sim.cursor.threads.size() != app.threads.size()) {
+    throw std::runtime_error("The checkpoint was saved with a different application.");
+  }
+
+  read(in, sim.sched);
+  index_cores(sim.sched, arch);
+  read(in, sim.sm);
+  read(in, sim.tl);
+  read(in, sim.stats);
+
+  if(!in) {
+    throw std::runtime_error("The checkpoint is truncated: " + file);
+  }
+
+  for(std::size_t core_id = 0; core_id < levels.size(); ++core_id) {
+    core_m &core = arch.cores[core_id];
+
+    core.level = levels[core_id];
+    core.frequency = core.type.frequencies.at(core.level);
+  }
+
+  // The saved residency was accounted for up to the checkpoint, the restored levels are accounted for from there.
+  update_residency(sim.stats, arch, sim.sched, sim.tl.now);
+
+  return sim;
+}
+
+} // namespace rhythm
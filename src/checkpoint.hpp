@@ -0,0 +1,29 @@
+#ifndef RHYTHM_CHECKPOINT_HPP
+#define RHYTHM_CHECKPOINT_HPP
+
+#include <string>
+
+#include "application.hpp"
+#include "architecture.hpp"
+#include "controller.hpp"
+
+namespace rhythm {
+
+/**
+ * Save the state of an estimation, including the frequency level of each core, to a file.
+ *
+ * The checkpoint records hashes of the application and architecture, so that it is only resumed with the same ones.
+ */
+void save_checkpoint(std::string const &file, app_m const &app, simulation_m const &sim, arch_m const &arch);
+
+/**
+ * Load the state of an estimation from a file, restoring the frequency level of each core.
+ *
+ * The application and architecture must be the ones that the checkpoint was saved with, otherwise an exception is
+ * thrown.
+ */
+simulation_m load_checkpoint(std::string const &file, app_m const &app, arch_m &arch);
+
+} // namespace rhythm
+
+#endif //RHYTHM_CHECKPOINT_HPP
@@ -6,7 +6,7 @@
 #include <cmath>
 #include <cstdint>
 #include <deque>
-#include <set>
+#include <limits>
 
 namespace rhythm {
 
@@ -30,11 +30,49 @@ constexpr thread_t INVALID_THREAD_ID = -1;
  */
 constexpr thread_t DEFAULT_MASTER_THREAD_ID = 0;
 
+/**
+ * @return The position of a thread in tables of per-thread state, which are indexed by thread ID.
+ */
+inline std::size_t thread_index(thread_t thread_id)
+{
+  return static_cast<std::size_t>(thread_id);
+}
+
 /**
  * Represents a memory address.
  */
 using address_t = std::uint64_t;
 
+/**
+ * Represents a synchronization object by a dense ID, assigned in order of appearance in the trace.
+ *
+ * Locks, barriers, and condition variables each have their own ID space.
+ */
+using object_t = std::uint32_t;
+
+/**
+ * An invalid object ID.
+ */
+constexpr object_t INVALID_OBJECT_ID = std::numeric_limits<object_t>::max();
+
+/**
+ * The hash of no bytes, from which hash_bytes starts.
+ */
+constexpr std::uint64_t EMPTY_HASH = 14695981039346656037ULL;
+
+/**
+ * @return The 64-bit FNV-1a hash of a sequence of bytes, continuing from the hash of the bytes before it.
+ */
+inline std::uint64_t hash_bytes(void const *data, std::size_t size, std::uint64_t hash = EMPTY_HASH)
+{
+  auto const *bytes = static_cast<unsigned char const *>(data);
+  for(std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+
+  return hash;
+}
+
 /**
  * Represent dynamic instruction counts as integers.
  */
@@ -50,6 +88,109 @@ using cpi_t = double;
  */
 using freq_t = std::int64_t;
 
+#ifdef __SIZEOF_INT128__
+/**
+ * Conversions between instructions and time in integer fixed-point arithmetic, which are bit-reproducible.
+ */
+namespace fixed_point {
+
+/**
+ * The rate at which a thread executes, in nanoseconds per instruction as a fixed-point number.
+ *
+ * The lowest RATE_FRACTION_BITS bits hold the fraction of a nanosecond.
+ */
+using rate_t = std::uint64_t;
+
+/**
+ * The number of fractional bits in a fixed-point rate.
+ */
+constexpr int RATE_FRACTION_BITS = 32;
+
+/**
+ * Intermediate products of instructions and rates need more than 64 bits.
+ */
+__extension__ using uint128_t = unsigned __int128;
+
+/**
+ * @return The time taken to execute one instruction, in nanoseconds, at the given CPI and frequency.
+ */
+inline rate_t estimate_rate(cpi_t const cpi, freq_t const frequency)
+{
+  // Each floating point operation here is correctly rounded, so the rate is the same on every platform.
+  auto const rate = std::ldexp(1e9 * cpi / static_cast<double>(frequency), RATE_FRACTION_BITS);
+
+  return std::max(rate_t{1}, static_cast<rate_t>(std::llround(rate)));
+}
+
+inline time_t estimate_time(icount_t const instructions, rate_t const rate)
+{
+  // Round up to the next nanosecond, so that a thread never reaches its event early.
+  uint128_t const round_up = (uint128_t{1} << RATE_FRACTION_BITS) - 1;
+  uint128_t const scaled = uint128_t{instructions} * rate + round_up;
+  auto const time = static_cast<std::uint64_t>(scaled >> RATE_FRACTION_BITS);
+
+  return time_t(time);
+}
+
+inline icount_t estimate_instructions(time_t const time, rate_t const rate)
+{
+  uint128_t const scaled = uint128_t{static_cast<std::uint64_t>(time.count())} << RATE_FRACTION_BITS;
+  auto const instructions = static_cast<icount_t>(scaled / rate);
+
+  return instructions;
+}
+
+} // namespace fixed_point
+#elif defined(RHYTHM_FIXED_POINT_TIME)
+#error "RHYTHM_FIXED_POINT_TIME requires a compiler with 128-bit integer support."
+#endif
+
+/**
+ * Conversions between instructions and time in double precision.
+ */
+namespace floating_point {
+
+/**
+ * The rate at which a thread executes, in nanoseconds per instruction.
+ */
+using rate_t = double;
+
+/**
+ * @return The time taken to execute one instruction, in nanoseconds, at the given CPI and frequency.
+ */
+inline rate_t estimate_rate(cpi_t const cpi, freq_t const frequency)
+{
+  return 1e9 * cpi / static_cast<double>(frequency);
+}
+
+inline time_t estimate_time(icount_t const instructions, rate_t const rate)
+{
+  auto const time = static_cast<std::uint64_t>(std::ceil(static_cast<double>(instructions) * rate));
+
+  return time_t(time);
+}
+
+inline icount_t estimate_instructions(time_t const time, rate_t const rate)
+{
+  auto const instructions = static_cast<icount_t>(static_cast<double>(time.count()) / rate);
+
+  return instructions;
+}
+
+} // namespace floating_point
+
+#ifdef RHYTHM_FIXED_POINT_TIME
+using fixed_point::estimate_instructions;
+using fixed_point::estimate_rate;
+using fixed_point::estimate_time;
+using fixed_point::rate_t;
+#else
+using floating_point::estimate_instructions;
+using floating_point::estimate_rate;
+using floating_point::estimate_time;
+using floating_point::rate_t;
+#endif
+
 /**
  * Transitions (e.g., context switches) that need to take place due to a synchronization event.
  */
@@ -57,18 +198,29 @@ struct transition_t {
   std::deque<thread_t> to_sleep;
   std::deque<thread_t> to_wake;
   std::deque<thread_t> to_kill;
+
+  /**
+   * Threads that wait for a lock without giving up their cores.
+   */
+  std::deque<thread_t> to_spin;
 };
 
 /**
  * The type of synchronization event.
  */
-enum class event_t {
+enum class event_t : std::uint8_t {
   barrier_wait,
   condition_broadcast,
   condition_signal,
+  condition_timeout,
   condition_wait,
   lock_acquire,
   lock_release,
+  lock_timeout,
+  rwlock_read_acquire,
+  rwlock_release,
+  rwlock_timeout,
+  rwlock_write_acquire,
   thread_create,
   thread_finish,
   thread_join,
@@ -96,18 +248,25 @@ struct event_m {
   icount_t distance = 0;
 
   /**
-   * The address of the synchronization object acted on.
+   * The ID of the synchronization object acted on.
    *
    * Only valid for certain event types.
    */
-  std::uint64_t object = 0;
+  object_t object = INVALID_OBJECT_ID;
 
   /**
-   * The address of a second synchronization object.
+   * The ID of a second synchronization object.
    *
    * Only valid for wait events on condition variables, which also require a mutex.
    */
-  std::uint64_t object2 = 0;
+  object_t object2 = INVALID_OBJECT_ID;
+
+  /**
+   * How long the thread waits before it gives up.
+   *
+   * Only valid for timeout events, which model timed waits that timed out.
+   */
+  time_t timeout{0};
 
   /**
    * The thread to wait for before continuing.
@@ -127,9 +286,27 @@ ostream &operator<<(ostream &os, event_t const &type)
   case event_t::lock_release:
     os << "release";
     break;
+  case event_t::rwlock_read_acquire:
+    os << "read_acquire";
+    break;
+  case event_t::rwlock_write_acquire:
+    os << "write_acquire";
+    break;
+  case event_t::rwlock_release:
+    os << "rwlock_release";
+    break;
   case event_t::condition_wait:
     os << "condition_wait";
     break;
+  case event_t::condition_timeout:
+    os << "condition_timeout";
+    break;
+  case event_t::lock_timeout:
+    os << "lock_timeout";
+    break;
+  case event_t::rwlock_timeout:
+    os << "rwlock_timeout";
+    break;
   case event_t::condition_signal:
     os << "signal";
     break;
@@ -168,6 +345,9 @@ ostream &operator<<(ostream &os, event_m const &em)
   switch(em.type) {
   case event_t::lock_acquire:
   case event_t::lock_release:
+  case event_t::rwlock_read_acquire:
+  case event_t::rwlock_release:
+  case event_t::rwlock_write_acquire:
   case event_t::barrier_wait:
   case event_t::condition_signal:
   case event_t::condition_broadcast:
@@ -176,6 +356,13 @@ ostream &operator<<(ostream &os, event_m const &em)
   case event_t::condition_wait:
     os << "[" << em.object << ", " << em.object2 << "]";
     break;
+  case event_t::lock_timeout:
+  case event_t::rwlock_timeout:
+    os << "[" << em.object << "] [" << em.timeout.count() << " ns]";
+    break;
+  case event_t::condition_timeout:
+    os << "[" << em.object << ", " << em.object2 << "] [" << em.timeout.count() << " ns]";
+    break;
   case event_t::thread_create:
   case event_t::thread_join:
     os << "[" << em.target_thread << "]";
@@ -186,23 +373,6 @@ ostream &operator<<(ostream &os, event_m const &em)
   return os;
 }
 
-inline time_t estimate_time(icount_t const instructions, cpi_t const cpi, freq_t const frequency)
-{
-  auto const cycles = static_cast<double>(instructions) * cpi;
-  auto const period = 1 / static_cast<double>(frequency);
-  auto const time = static_cast<std::uint64_t>(std::ceil(1e9 * cycles * period));
-
-  return time_t(time);
-}
-
-inline icount_t estimate_instructions(time_t const time, cpi_t const cpi, freq_t const frequency)
-{
-  auto const cycles = static_cast<double>(time.count()) * static_cast<double>(frequency) * 1e-9;
-  auto const instructions = static_cast<icount_t>(cycles / cpi);
-
-  return instructions;
-}
-
 } // namespace rhythm
 
 #endif //RHYTHM_COMMON_HPP
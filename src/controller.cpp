@@ -1,65 +1,328 @@
 #include "controller.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 #include "spdlog/spdlog.h"
 
+#include "governor.hpp"
 #include "statistics.hpp"
 
 namespace rhythm {
 
-thread_t select_next_thread(app_m const &app,
+void place_on_timeline(app_m const &app,
+    app_cursor &cursor,
     arch_m const &arch,
     sched_m const &sched,
-    time_t &shortest_time)
+    timeline_m &tl,
+    thread_t thread_id)
 {
-  assert(!sched.running_threads.empty());
+  if(is_spinning(sched, thread_id)) {
+    // The thread occupies its core without progressing until it acquires its lock, gives up or is preempted.
+    hold(tl, thread_id, std::min(slice_end(arch, sched, thread_id), spin_end(sched, thread_id)));
+    return;
+  }
 
-  shortest_time = time_t::max();
-  thread_t next_thread = *sched.running_threads.begin();
+  event_m const event = get_current_event(app.threads.at(thread_id), cursor.threads.at(thread_id));
+  icount_t const next_phase = enter_phase(arch, sched, cursor, thread_id);
 
-  for(thread_t const &thread_id : sched.running_threads) {
-    auto thread_it = app.threads.find(thread_id);
-    assert(thread_it != app.threads.end());
+  cpi_t const cpi_rate = get_cpi(arch, sched, cursor, thread_id);
+  freq_t const frequency = get_freq(arch, sched, thread_id);
+  rate_t const rate = estimate_rate(cpi_rate, frequency);
 
-    event_m const event = get_current_event(thread_it->second);
-    icount_t const instructions = event.distance;
+  time_t const start = std::max(tl.now, switched_in(sched, thread_id));
+  time_t deadline = slice_end(arch, sched, thread_id);
 
-    cpi_t const cpi_rate = get_cpi(arch, sched, thread_id);
-    freq_t const frequency = get_freq(arch, sched, thread_id);
+  if(next_phase < event.distance) {
+    // The thread moves to its next CPI phase before it reaches its event.
+    deadline = std::min(deadline, start + estimate_time(next_phase, rate));
+  }
 
-    time_t time_till_event = estimate_time(instructions, cpi_rate, frequency);
+  insert(tl, thread_id, event.distance, rate, start, deadline);
+}
 
-    if(time_till_event < shortest_time) {
-      next_thread = thread_id;
-      shortest_time = time_till_event;
+/**
+ * Bring the cursor of a thread on the timeline up to date with the current time.
+ */
+void catch_up(app_m const &app, app_cursor &cursor, timeline_m &tl, thread_t thread_id)
+{
+  auto const &thread = app.threads.at(thread_id);
+  auto &position = cursor.threads.at(thread_id);
+
+  icount_t const executed = catch_up(tl, thread_id);
+
+  // A single conversion from time can round past the event by a fraction of an instruction.
+  icount_t const remaining = get_current_event(thread, position).distance;
+  execute(thread, position, std::min(executed, remaining));
+}
+
+void update_timeline(app_m const &app, app_cursor &cursor, arch_m const &arch, sched_m &sched, timeline_m &tl)
+{
+  for(thread_t const &thread_id : sched.remapped_threads) {
+    if(is_active(tl, thread_id)) {
+      // Account for the progress made at the previous rate before the thread moves.
+      catch_up(app, cursor, tl, thread_id);
+    }
+
+    if(sched.running_threads.contains(thread_id)) {
+      place_on_timeline(app, cursor, arch, sched, tl, thread_id);
+    } else {
+      remove(tl, thread_id);
     }
   }
 
-  return next_thread;
+  sched.remapped_threads.clear();
 }
 
-time_t step(app_m &app, arch_m &arch, sched_m &sched, sync_m &sm, stats_t &stats)
+/**
+ * Charge the cost of a synchronization event as delays before the threads involved can progress.
+ */
+void charge_sync_costs(arch_m const &arch,
+    sched_m &sched,
+    sync_m const &sm,
+    stats_t &stats,
+    event_m const &event,
+    transition_t const &t,
+    time_t now)
 {
-  time_t elapsed_time(0);
+  auto const &costs = arch.sync_costs;
+
+  // The cost to the thread that reached the event, if it keeps running, and to each thread that it wakes up.
+  time_t cost{0};
+  time_t wake_up_cost = costs.wake_up;
+
+  switch(event.type) {
+  case event_t::lock_acquire:
+  case event_t::rwlock_read_acquire:
+  case event_t::rwlock_write_acquire:
+    if(t.to_sleep.empty() && t.to_spin.empty()) {
+      cost = costs.lock_acquire;
+    }
+    break;
+  case event_t::lock_release:
+  case event_t::rwlock_release:
+    wake_up_cost = costs.lock_hand_off;
+    break;
+  case event_t::barrier_wait:
+    // Arrivals are serialized on the barrier, so the release takes longer the more threads take part.
+    wake_up_cost = costs.barrier_release +
+        costs.barrier_arrival * static_cast<std::int64_t>(sm.barriers.at(event.object).count);
+    if(t.to_sleep.empty()) {
+      cost = wake_up_cost;
+    }
+    break;
+  case event_t::thread_create:
+    cost = costs.thread_create;
+    wake_up_cost = costs.thread_create;
+    break;
+  default:
+    break;
+  }
+
+  if(cost > time_t(0)) {
+    delay(sched, event.thread_id, now + cost);
+  }
+
+  for(auto const &thread_id : t.to_wake) {
+    time_t latency{0};
+
+    if(event.type == event_t::lock_release || event.type == event_t::rwlock_release ||
+        event.type == event_t::barrier_wait) {
+      // A lock hand-off or barrier wake-up takes longer to reach a thread on another socket.
+      latency = remote_latency(arch, sched, event.thread_id, thread_id);
+      update_remote(stats, event, thread_id, latency);
+    }
+
+    if(wake_up_cost + latency > time_t(0)) {
+      delay(sched, thread_id, now + wake_up_cost + latency);
+    }
+  }
+}
+
+/**
+ * @return Whether no running thread can progress, because each one spins on a lock without a spin window or time slice
+ * that would take it off its core.
+ */
+bool is_stalled(arch_m const &arch, sched_m const &sched)
+{
+  for(auto const &thread_id : sched.running_threads) {
+    if(!is_spinning(sched, thread_id) || spin_end(sched, thread_id) != time_t::max() ||
+        slice_end(arch, sched, thread_id) != time_t::max()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Wake up threads if every live thread is blocked, or spins forever, and no timed wait is left to wake one of them.
+ *
+ * @param thread_id The thread whose step left the others blocked.
+ */
+void resolve_deadlock(app_m const &app, arch_m const &arch, simulation_m &sim, thread_t thread_id)
+{
+  if(!is_stalled(arch, sim.sched) || sim.sm.live_threads.empty() || has_timers(sim.tl)) {
+    return;
+  }
+
+  spdlog::get("log")->info("Breaking deadlock.");
+  transition_t const t = break_deadlock(sim.sm, thread_id, arch.rwlock_preference);
+  schedule(sim.sched, arch, app, sim.cursor, sim.sm.threads, t, sim.tl.now);
+}
+
+void create_master_thread(app_m const &app,
+    arch_m const &arch,
+    simulation_m &sim,
+    thread_t thread_id = DEFAULT_MASTER_THREAD_ID)
+{
+  sim.sm.live_threads.insert(thread_id);
+
+  transition_t t{};
+  t.to_wake.push_back(thread_id);
+  schedule(sim.sched, arch, app, sim.cursor, sim.sm.threads, t, sim.tl.now);
+}
+
+simulation_m start(app_m &app, arch_m &arch, sync_m const &initial)
+{
+  simulation_m sim{app_cursor(app), sched_m{}, initial, timeline_m{}, stats_t{}};
+
+  for(std::size_t core_id = 0; core_id < arch.cores.size(); ++core_id) {
+    sim.sched.idle_cores.push_back(core_id);
+  }
+  index_cores(sim.sched, arch);
+
+  // Analogous to running the "main" function of a program.
+  create_master_thread(app, arch, sim);
+  govern(arch, sim.sched, sim.sm);
+  update_residency(sim.stats, arch, sim.sched, sim.tl.now);
+  pop_current_event(app.threads.at(DEFAULT_MASTER_THREAD_ID), sim.cursor.threads.at(DEFAULT_MASTER_THREAD_ID));
+
+  return sim;
+}
+
+/**
+ * @return Whether the cores of both architectures offer the same frequency levels.
+ */
+bool same_frequencies(arch_m const &arch1, arch_m const &arch2)
+{
+  if(arch1.cores.size() != arch2.cores.size()) {
+    return false;
+  }
+
+  for(std::size_t core_id = 0; core_id < arch1.cores.size(); ++core_id) {
+    if(arch1.cores[core_id].type.frequencies != arch2.cores[core_id].type.frequencies) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+simulation_m fork(simulation_m const &sim, arch_m const &from, arch_m &to)
+{
+  simulation_m forked = sim;
+
+  // The prefix ran at the levels of its own configuration, the fork is accounted for from the levels of its own.
+  flush_residency(forked.stats, forked.tl.now);
+  forked.stats.levels.clear();
+  forked.stats.level_since.clear();
+
+  attach(forked.sched, to);
+  govern(to, forked.sched, forked.sm);
+
+  if(!same_frequencies(from, to)) {
+    forked.stats.frequency_residency.clear();
+  }
+
+  update_residency(forked.stats, to, forked.sched, forked.tl.now);
+
+  return forked;
+}
+
+bool is_finished(simulation_m const &sim)
+{
+  return sim.sm.live_threads.empty();
+}
+
+time_t step(app_m &app, arch_m &arch, simulation_m &sim)
+{
+  auto &cursor = sim.cursor;
+  auto &sched = sim.sched;
+  auto &sm = sim.sm;
+  auto &tl = sim.tl;
+  auto &stats = sim.stats;
+
+  // Only threads that were mapped to or removed from a core, or whose contention changed as a result, need their
+  // progress and event times updated.
+  update_contention(arch, sched, cursor);
+  update_timeline(app, cursor, arch, sched, tl);
 
   // Select the next thread based on which thread will reach a synchronization event first.
-  thread_t const current_thread = select_next_thread(app, arch, sched, elapsed_time);
+  time_t const start_time = tl.now;
+  timeline_event const next = pop_next_thread(tl);
+  thread_t const current_thread = next.thread_id;
+  time_t const elapsed_time = tl.now - start_time;
+
+  if(next.timer) {
+    // The thread was blocked in a timed wait that timed out.
+    update(stats, elapsed_time, sm);
+
+#ifndef NDEBUG
+    spdlog::get("rhythm-trace")
+        ->info("Timed wait of thread {} timed out [{} ns] [{} ns]", current_thread, elapsed_time.count(),
+            stats.total_time.count());
+#endif
+
+    transition_t const t = time_out(sm, current_thread);
+    for(auto const &thread_id : t.to_wake) {
+      if(arch.sync_costs.wake_up > time_t(0)) {
+        delay(sched, thread_id, tl.now + arch.sync_costs.wake_up);
+      }
+    }
+
+    schedule(sched, arch, app, cursor, sm.threads, t, tl.now);
+    resolve_deadlock(app, arch, sim, current_thread);
+    govern(arch, sched, sm);
+    update_residency(stats, arch, sched, tl.now);
+
+    return elapsed_time;
+  }
+
+  if(next.expiry) {
+    // The thread has not reached its event, it only gives up its core if another thread should run instead.
+    update(stats, elapsed_time, sm);
 
-  for(thread_t const &thread_id : sched.running_threads) {
-    auto thread_it = app.threads.find(thread_id);
-    assert(thread_it != app.threads.end());
+#ifndef NDEBUG
+    spdlog::get("rhythm-trace")
+        ->info("Time slice or CPI phase of thread {} ended [{} ns] [{} ns]", current_thread, elapsed_time.count(),
+            stats.total_time.count());
+#endif
 
-    if(elapsed_time.count() > 0) {
-      cpi_t const cpi_rate = get_cpi(arch, sched, thread_id);
-      freq_t const frequency = get_freq(arch, sched, thread_id);
-      icount_t const instructions = estimate_instructions(elapsed_time, cpi_rate, frequency);
+    // The scheduler places the thread by how far it is from its next event.
+    catch_up(app, cursor, tl, current_thread);
 
-      execute(thread_it->second, instructions);
+    if(tl.now >= slice_end(arch, sched, current_thread)) {
+      expire(sched, arch, app, cursor, sm.threads, current_thread, tl.now);
+    } else if(is_spinning(sched, current_thread)) {
+      // The spin window passed before the thread acquired its lock.
+      stop_spinning(sched, arch, app, cursor, sm.threads, current_thread, tl.now);
+    } else {
+      // The thread continues on the same core, at the rate of its new CPI phase.
+      sched.remapped_threads.insert(current_thread);
     }
+
+    resolve_deadlock(app, arch, sim, current_thread);
+    govern(arch, sched, sm);
+    update_residency(stats, arch, sched, tl.now);
+
+    return elapsed_time;
   }
 
-  event_m const current_event = get_current_event(app.threads.at(current_thread));
+  auto &current_model = app.threads.at(current_thread);
+  auto &current_cursor = cursor.threads.at(current_thread);
+
+  event_m const current_event = get_current_event(current_model, current_cursor);
   update(stats, elapsed_time, current_event, sm);
 
 #ifndef NDEBUG
@@ -68,23 +331,55 @@ time_t step(app_m &app, arch_m &arch, sched_m &sched, sync_m &sm, stats_t &stats
     stream << t << ", ";
   }
 
-  auto const running_time = stats.status_time[current_thread].times[thread_status::running].count();
+  auto const running_time = stats.status_time[thread_index(current_thread)][thread_status::running].count();
   spdlog::get("rhythm-trace")
       ->info("{} [{} ns] [{} ns] [{} ns] [{}]", current_event, elapsed_time.count(), running_time,
           stats.total_time.count(), stream.str());
 #endif
 
-  transition_t const state_changes = synchronize(sm, current_event);
-  schedule(sched, sm.threads, state_changes);
+  transition_t state_changes = synchronize(sm, current_event, arch.rwlock_preference);
+
+  // An adaptive mutex spins for a while before the thread blocks.
+  bool const adaptive = arch.spin_window > time_t(0) && current_event.type == event_t::lock_acquire &&
+      !state_changes.to_sleep.empty();
+  if(adaptive) {
+    state_changes.to_spin.swap(state_changes.to_sleep);
+  }
+
+  charge_sync_costs(arch, sched, sm, stats, current_event, state_changes, tl.now);
+  schedule(sched, arch, app, cursor, sm.threads, state_changes, tl.now);
+
+  if(adaptive) {
+    // Unlike a spin lock, the thread blocks once its spin window has passed.
+    spin(sched, sm.threads.at(current_thread), tl.now + arch.spin_window);
+  }
 
-  if(sched.running_threads.empty() && !sm.live_threads.empty()) {
-    spdlog::get("log")->info("Breaking deadlock.");
-    transition_t const t = break_deadlock(sm, current_thread);
-    schedule(sched, sm.threads, t);
+  if(current_event.type == event_t::lock_timeout || current_event.type == event_t::rwlock_timeout ||
+      current_event.type == event_t::condition_timeout) {
+    // The thread stays blocked until its timeout expires.
+    set_timer(tl, current_thread, tl.now + current_event.timeout);
   }
 
-  assert(current_event.distance <= 1);
-  pop_current_event(app.threads.at(current_thread));
+  resolve_deadlock(app, arch, sim, current_thread);
+
+  // Threads that were mapped to or removed from a core may change the frequency of their cores.
+  govern(arch, sched, sm);
+  update_residency(stats, arch, sched, tl.now);
+
+  pop_current_event(current_model, current_cursor);
+
+  if(sched.running_threads.contains(current_thread) && !sched.remapped_threads.contains(current_thread)) {
+    event_m const next_event = get_current_event(current_model, current_cursor);
+
+    if(changed_phase(arch, sched, cursor, current_thread) ||
+        enter_phase(arch, sched, cursor, current_thread) < next_event.distance) {
+      // The thread starts a new CPI phase at this event or before the next, so it needs a new rate or deadline.
+      sched.remapped_threads.insert(current_thread);
+    } else {
+      // The current thread continues on the same core, at the same rate, towards its next event.
+      insert(tl, current_thread, next_event.distance);
+    }
+  }
 
   return elapsed_time;
 }
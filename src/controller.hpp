@@ -6,13 +6,47 @@
 #include "system-model.hpp"
 #include "synchronization-model.hpp"
 #include "statistics.hpp"
+#include "timeline.hpp"
 
 namespace rhythm {
 
+/**
+ * The complete state of an estimation, apart from the application and architecture it runs on.
+ *
+ * A simulation can be copied to fork an estimation at its current point, or saved as a checkpoint.
+ */
+struct simulation_m {
+  app_cursor cursor;
+  sched_m sched;
+  sync_m sm;
+  timeline_m tl;
+  stats_t stats;
+};
+
+/**
+ * Start an estimation, with the master thread ready to run its first event.
+ *
+ * @param initial The synchronization model found while loading the application.
+ */
+simulation_m start(app_m &app, arch_m &arch, sync_m const &initial);
+
+/**
+ * @return A copy of a simulation that continues on a different architecture.
+ *
+ * The frequency residency of the original simulation is only kept if both architectures have the same cores and
+ * frequency levels.
+ */
+simulation_m fork(simulation_m const &sim, arch_m const &from, arch_m &to);
+
+/**
+ * @return Whether all threads of the simulation have finished.
+ */
+bool is_finished(simulation_m const &sim);
+
 /**
  * Execute up to the next synchronization event on the critical path.
  */
-time_t step(app_m &app, arch_m &arch, sched_m &sched, sync_m &sm, stats_t &stats);
+time_t step(app_m &app, arch_m &arch, simulation_m &sim);
 
 } // namespace rhythm
 
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/stdout_sinks.h"
+
+#include "argagg.hpp"
+
+#include "trace-format.hpp"
+
+argagg::parser create_command_line_interface()
+{
+  return {{{"help", {"-h", "--help"}, "Display help information.", 0},
+      {"trace", {"-t", "--trace-manifest"}, "Manifest of all trace files.", 1},
+      {"output", {"-o", "--output"}, "Binary trace file to create.", 1}}};
+}
+
+void print_usage(std::ostream &stream, argagg::parser const &arguments)
+{
+  argagg::fmt_ostream help(stream);
+
+  help << "Convert the text traces listed in a manifest into a single binary trace.\n\n";
+  help << "rhythm-convert [options] ARG [ARG...]\n\n";
+  help << arguments;
+}
+
+void validate(argagg::parser_results const &options)
+{
+  if(options["trace"].count() == 0) {
+    throw std::runtime_error("Missing path to trace manifest file.");
+  }
+
+  if(options["output"].count() == 0) {
+    throw std::runtime_error("Missing path to output file.");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  try {
+    spdlog::stdout_logger_st("log");
+
+    // Parse the command line.
+    auto interface = create_command_line_interface();
+    auto const arguments = interface.parse(argc, argv);
+
+    // Check if help was requested.
+    if(arguments["help"]) {
+      print_usage(std::cout, interface);
+
+      return EXIT_SUCCESS;
+    }
+
+    // Make sure we have the required arguments.
+    validate(arguments);
+
+    auto const manifest_file = arguments["trace"].as<std::string>();
+    auto const output_file = arguments["output"].as<std::string>();
+
+    spdlog::get("log")->info("Converting trace manifest file: {}", manifest_file);
+    rhythm::write_binary_trace(manifest_file, output_file);
+    spdlog::get("log")->info("Binary trace written to {}", output_file);
+  } catch(std::exception const &e) {
+    spdlog::get("log")->error("{}", e.what());
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
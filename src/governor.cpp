@@ -0,0 +1,170 @@
+#include "governor.hpp"
+
+#include <algorithm>
+
+namespace rhythm {
+
+namespace {
+
+std::size_t lowest_level(core_t const &type)
+{
+  std::size_t lowest = 0;
+  for(std::size_t level = 1; level < type.frequencies.size(); ++level) {
+    if(type.frequencies[level] < type.frequencies[lowest]) {
+      lowest = level;
+    }
+  }
+
+  return lowest;
+}
+
+std::size_t highest_level(core_t const &type)
+{
+  std::size_t highest = 0;
+  for(std::size_t level = 1; level < type.frequencies.size(); ++level) {
+    if(type.frequencies[level] > type.frequencies[highest]) {
+      highest = level;
+    }
+  }
+
+  return highest;
+}
+
+/**
+ * @return The level with the highest frequency that does not exceed the limit, or the lowest level if none do.
+ */
+std::size_t level_within(core_t const &type, freq_t limit)
+{
+  std::size_t best = lowest_level(type);
+  for(std::size_t level = 0; level < type.frequencies.size(); ++level) {
+    freq_t const frequency = type.frequencies[level];
+
+    if(frequency <= limit && frequency > type.frequencies[best]) {
+      best = level;
+    }
+  }
+
+  return best;
+}
+
+std::size_t static_level(governor_t const &governor, core_t const &type, thread_t thread_id)
+{
+  std::size_t level = 0;
+  if(thread_index(thread_id) < governor.static_levels.size()) {
+    level = governor.static_levels[thread_id];
+  }
+
+  // Core types may offer fewer levels than the thread was given.
+  return std::min(level, type.frequencies.size() - 1);
+}
+
+bool holds_contended_lock(sync_m const &sm, thread_t thread_id)
+{
+  for(auto const lock_id : sm.threads.at(thread_id).locks_held) {
+    if(!sm.locks.at(lock_id).waiters.empty()) {
+      return true;
+    }
+  }
+
+  for(auto const rwlock_id : sm.threads.at(thread_id).rwlocks_held) {
+    if(!sm.rwlocks.at(rwlock_id).waiters.empty()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Set the frequency of a core according to the governor of the architecture.
+ *
+ * @param share The frequency budget of each running thread under the budget policy.
+ */
+void govern_core(arch_m &arch, sched_m &sched, sync_m const &sm, std::size_t core_id, freq_t share)
+{
+  governor_t const &governor = arch.governor;
+
+  core_t const &type = arch.cores[core_id].type;
+  thread_t const thread_id = sched.core_threads[core_id];
+
+  if(thread_id == INVALID_THREAD_ID) {
+    // Idle cores keep their frequency unless the policy saves power while idle.
+    if(governor.policy == governor_policy::race_to_idle || governor.policy == governor_policy::budget) {
+      set_frequency(arch, sched, core_id, lowest_level(type));
+    }
+
+    return;
+  }
+
+  switch(governor.policy) {
+  case governor_policy::static_levels:
+    set_frequency(arch, sched, core_id, static_level(governor, type, thread_id));
+    break;
+  case governor_policy::race_to_idle:
+    set_frequency(arch, sched, core_id, highest_level(type));
+    break;
+  case governor_policy::budget:
+    set_frequency(arch, sched, core_id, level_within(type, share));
+    break;
+  case governor_policy::lock_aware:
+    if(holds_contended_lock(sm, thread_id)) {
+      set_frequency(arch, sched, core_id, highest_level(type));
+    } else {
+      set_frequency(arch, sched, core_id, static_level(governor, type, thread_id));
+    }
+    break;
+  }
+}
+
+} // namespace
+
+void govern(arch_m &arch, sched_m &sched, sync_m const &sm)
+{
+  if(sched.remapped_threads.empty() && sched.remapped_cores.empty()) {
+    return;
+  }
+
+  governor_t const &governor = arch.governor;
+
+  freq_t share = 0;
+  if(governor.policy == governor_policy::budget && !sched.running_threads.empty()) {
+    share = governor.budget / static_cast<freq_t>(sched.running_threads.size());
+  }
+
+  if(governor.policy == governor_policy::budget || governor.policy == governor_policy::lock_aware) {
+    // The share of the budget, or which locks are contended, may have changed for threads that did not move.
+    for(auto const &thread_id : sched.running_threads) {
+      govern_core(arch, sched, sm, sched.mapping[thread_id], share);
+    }
+  }
+
+  // The policies only depend on whether a core is busy and on the thread running on it.
+  for(auto const core_id : sched.remapped_cores) {
+    govern_core(arch, sched, sm, core_id, share);
+  }
+
+  sched.remapped_cores.clear();
+}
+
+freq_t placement_frequency(arch_m const &arch, sched_m const &sched, std::size_t core_id, thread_t thread_id)
+{
+  governor_t const &governor = arch.governor;
+  core_t const &type = arch.cores.at(core_id).type;
+
+  // Under the budget policy, the thread would share the budget with the threads that are already running.
+  freq_t const share = governor.budget / static_cast<freq_t>(sched.running_threads.size() + 1);
+
+  switch(governor.policy) {
+  case governor_policy::static_levels:
+  case governor_policy::lock_aware:
+    return type.frequencies[static_level(governor, type, thread_id)];
+  case governor_policy::race_to_idle:
+    return type.frequencies[highest_level(type)];
+  case governor_policy::budget:
+    return type.frequencies[level_within(type, share)];
+  }
+
+  return arch.cores[core_id].frequency;
+}
+
+} // namespace rhythm
@@ -0,0 +1,30 @@
+#ifndef RHYTHM_GOVERNOR_HPP
+#define RHYTHM_GOVERNOR_HPP
+
+#include "architecture.hpp"
+#include "synchronization-model.hpp"
+#include "system-model.hpp"
+
+namespace rhythm {
+
+/**
+ * Set the frequency of each core according to the governor of the architecture.
+ *
+ * Only the cores that threads have been mapped to or removed from are reconsidered, since that is when the decisions
+ * of the static and race-to-idle policies can change. The budget and lock-aware policies also reconsider the cores of
+ * the other running threads, whose share of the budget or contended locks may have changed.
+ */
+void govern(arch_m &arch, sched_m &sched, sync_m const &sm);
+
+/**
+ * @return The frequency that a core would run at under the governor, if a thread that is waiting to run was placed on
+ * it.
+ *
+ * The lock-aware policy is assumed to run the thread at its static level, since whether its locks become contended is
+ * not known yet.
+ */
+freq_t placement_frequency(arch_m const &arch, sched_m const &sched, std::size_t core_id, thread_t thread_id);
+
+} // namespace rhythm
+
+#endif //RHYTHM_GOVERNOR_HPP
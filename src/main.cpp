@@ -14,9 +14,21 @@
 argagg::parser create_command_line_interface()
 {
   return {{{"help", {"-h", "--help"}, "Display help information.", 0},
-      {"config", {"-c", "--config"}, "System configuration.", 1},
-      {"trace", {"-t", "--trace-manifest"}, "Manifest of all trace files.", 1},
-      {"output", {"-o", "--output-dir"}, "Output directory.", 1}}};
+      {"config", {"-c", "--config"},
+          "System configuration. Repeat to estimate several configurations, each in its own subdirectory.", 1},
+      {"trace", {"-t", "--trace-manifest"}, "Manifest of all trace files, or a binary trace.", 1},
+      {"output", {"-o", "--output-dir"}, "Output directory.", 1},
+      {"window", {"-w", "--stream-window"},
+          "Stream events from the traces, holding at most this many events per thread in memory.", 1},
+      {"jobs", {"-j", "--jobs"},
+          "Number of configurations to estimate at once (default: one per hardware thread).", 1},
+      {"fork", {"--fork-at"},
+          "Estimate all configurations as one up to this point, in nanoseconds or \"create\" for the first "
+          "thread creation, then fork them.", 1},
+      {"save", {"--checkpoint"}, "Save the estimation to this file, at the point given by --checkpoint-at.", 1},
+      {"save_at", {"--checkpoint-at"},
+          "When to save the checkpoint, in nanoseconds or \"create\" for the first thread creation.", 1},
+      {"resume", {"--resume"}, "Resume the estimation from a checkpoint.", 1}}};
 }
 
 void print_usage(std::ostream &stream, argagg::parser const &arguments)
@@ -41,15 +53,31 @@ void validate(argagg::parser_results const &options)
   if(options["output"].count() == 0) {
     throw std::runtime_error("Missing path to output directory.");
   }
+
+  if(options["config"].count() > 1 && options["window"].count() > 0) {
+    throw std::runtime_error("Streaming cannot be used when estimating several configurations.");
+  }
+
+  if(options["config"].count() > 1 && (options["save"] || options["resume"])) {
+    throw std::runtime_error("Checkpoints cannot be used when estimating several configurations.");
+  }
+
+  if(options["config"].count() == 1 && options["fork"]) {
+    throw std::runtime_error("Forking requires several configurations.");
+  }
+
+  if(options["save"].count() != options["save_at"].count()) {
+    throw std::runtime_error("A checkpoint requires both --checkpoint and --checkpoint-at.");
+  }
 }
 
 void setup_loggers()
 {
-  // Create the logger.
-  spdlog::stdout_logger_st("log");
+  // Create the logger, which is shared by concurrent estimations.
+  spdlog::stdout_logger_mt("log");
 
 #ifndef NDEBUG
-  spdlog::basic_logger_st("rhythm-trace", "rhythm-trace.txt", true);
+  spdlog::basic_logger_mt("rhythm-trace", "rhythm-trace.txt", true);
   spdlog::get("rhythm-trace")->set_pattern("[%n] %v");
 #endif
 }
@@ -74,10 +102,29 @@ int main(int argc, char **argv)
     validate(arguments);
 
     auto const manifest_file = arguments["trace"].as<std::string>();
-    auto const config_file = arguments["config"].as<std::string>();
     auto const output_dir = arguments["output"].as<std::string>();
 
-    rhythm::estimate(manifest_file, config_file, output_dir);
+    if(arguments["config"].count() > 1) {
+      std::vector<std::string> config_files;
+      for(auto const &config : arguments["config"].all) {
+        config_files.push_back(config.as<std::string>());
+      }
+
+      auto const jobs = arguments["jobs"].as<std::size_t>(0);
+      auto const fork_at = arguments["fork"].as<std::string>("");
+
+      rhythm::estimate(manifest_file, config_files, output_dir, jobs, fork_at);
+    } else {
+      auto const config_file = arguments["config"].as<std::string>();
+      auto const window = arguments["window"].as<std::size_t>(0);
+
+      rhythm::checkpoint_options checkpoint;
+      checkpoint.save_file = arguments["save"].as<std::string>("");
+      checkpoint.save_at = arguments["save_at"].as<std::string>("");
+      checkpoint.resume_file = arguments["resume"].as<std::string>("");
+
+      rhythm::estimate(manifest_file, config_file, output_dir, window, checkpoint);
+    }
   } catch(std::exception const &e) {
     spdlog::get("log")->error("{}", e.what());
 
@@ -1,31 +1,122 @@
 #include "rhythm.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <future>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/stat.h>
+
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_sinks.h"
 
 #include "architecture.hpp"
+#include "checkpoint.hpp"
 #include "controller.hpp"
 #include "synchronization-model.hpp"
 #include "system-model.hpp"
+#include "thread-pool.hpp"
 #include "trace.hpp"
 
 namespace rhythm {
 
-void create_master_thread(sched_m &sched, sync_m &sm, thread_t thread_id = DEFAULT_MASTER_THREAD_ID)
+/**
+ * @return The name of a configuration file, without its directory or extension.
+ */
+std::string config_name(std::string const &config_file)
+{
+  auto const start = config_file.find_last_of('/') + 1;
+  auto const end = config_file.find_last_of('.');
+
+  if(end == std::string::npos || end <= start) {
+    return config_file.substr(start);
+  }
+
+  return config_file.substr(start, end - start);
+}
+
+void create_directory(std::string const &directory)
+{
+  if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw std::runtime_error("Could not create output directory: " + directory);
+  }
+}
+
+void log_models(app_m const &app, sync_m const &sm)
+{
+  spdlog::get("log")->info("{}", sm);
+  spdlog::get("log")->info("{}", app);
+  for(auto const &tm : app.threads) {
+    spdlog::get("log")->info("{}", tm);
+  }
+}
+
+/**
+ * A point at which an estimation is paused, for example to fork or save it.
+ */
+using stop_condition = std::function<bool(simulation_m const &sim)>;
+
+/**
+ * @param point Either a simulated time in nanoseconds, or "create" to stop once the master thread has created
+ * another thread.
+ */
+stop_condition parse_stop_condition(std::string const &point)
+{
+  if(point == "create") {
+    return [](simulation_m const &sim) { return sim.sm.live_threads.size() > 1; };
+  }
+
+  std::size_t end = 0;
+  auto const nanoseconds = std::stoll(point, &end);
+  if(end != point.size() || nanoseconds < 0) {
+    throw std::runtime_error("Invalid point in the estimation: " + point);
+  }
+
+  time_t const time(nanoseconds);
+  return [time](simulation_m const &sim) { return sim.stats.total_time >= time; };
+}
+
+/**
+ * Estimate until all threads have finished, or until the stop condition holds.
+ */
+void advance(app_m &app, arch_m &arch, simulation_m &sim, stop_condition const &stop)
+{
+  while(!is_finished(sim) && !(stop && stop(sim))) {
+    auto const elapsed_time = step(app, arch, sim);
+    sim.stats.total_time += elapsed_time;
+  }
+}
+
+/**
+ * Estimate until all threads have finished and write the results.
+ *
+ * @return The estimated execution time, in seconds.
+ */
+double finish(app_m &app, arch_m &arch, simulation_m &sim, std::string const &output_dir)
 {
-  sm.threads.at(thread_id).status = thread_status::running;
+  advance(app, arch, sim, nullptr);
 
-  sched.running_threads.insert(thread_id);
-  sm.live_threads.insert(thread_id);
+  flush_residency(sim.stats, sim.tl.now);
+  print(sim.stats, arch, *app.objects, output_dir);
 
-  sched.mapping.emplace(thread_id, 0);
-  sched.idle_cores.pop_front();
+  // Using a duration with type double gives us the time in seconds.
+  return std::chrono::duration<double>(sim.stats.total_time).count();
 }
 
 void estimate(std::string const &manifest_file,
     std::string const &config_file,
-    std::string const &output_dir)
+    std::string const &output_dir,
+    std::size_t window,
+    checkpoint_options const &checkpoint)
 {
+  if(window > 0 && !(checkpoint.save_file.empty() && checkpoint.resume_file.empty())) {
+    throw std::runtime_error("Checkpoints cannot be used while streaming.");
+  }
+
   spdlog::get("log")->info("Loading model configuration file: {}", config_file);
   arch_m arch = parse_config_file(config_file);
   spdlog::get("log")->info("Model configuration file loaded successfully.", config_file);
@@ -33,38 +124,90 @@ void estimate(std::string const &manifest_file,
   sync_m sm{};
 
   spdlog::get("log")->info("Loading trace manifest file: {}", manifest_file);
-  app_m app = parse_traces(manifest_file, sm);
+  app_m app = window > 0 ? stream_traces(manifest_file, sm, window) : parse_traces(manifest_file, sm);
   spdlog::get("log")->info("All trace files loaded successfully.");
 
-  spdlog::get("log")->info("{}", sm);
-  spdlog::get("log")->info("{}", app);
-  for(auto const &tm : app.threads) {
-    spdlog::get("log")->info("{}", tm.second);
-  }
+  log_models(app, sm);
 
-  sched_m sched{};
-  for(std::size_t core_id = 0; core_id < arch.cores.size(); ++core_id) {
-    sched.idle_cores.push_back(core_id);
+  if(!checkpoint.resume_file.empty()) {
+    spdlog::get("log")->info("Resuming from checkpoint: {}", checkpoint.resume_file);
   }
 
-  // Analogous to running the "main" function of a program.
-  create_master_thread(sched, sm);
-  pop_current_event(app.threads.at(DEFAULT_MASTER_THREAD_ID));
-
-  stats_t stats{};
+  simulation_m sim = checkpoint.resume_file.empty() ? start(app, arch, sm)
+                                                    : load_checkpoint(checkpoint.resume_file, app, arch);
 
   spdlog::get("log")->info("Starting estimation.");
 
-  while(!sm.live_threads.empty()) {
-    auto const elapsed_time = step(app, arch, sched, sm, stats);
-    stats.total_time += elapsed_time;
+  if(!checkpoint.save_file.empty()) {
+    advance(app, arch, sim, parse_stop_condition(checkpoint.save_at));
+    save_checkpoint(checkpoint.save_file, app, sim, arch);
+
+    spdlog::get("log")->info("Checkpoint saved at {} ns: {}", sim.stats.total_time.count(), checkpoint.save_file);
   }
 
-  // Using a duration with type double gives us the time in seconds.
-  auto const execution_time = std::chrono::duration<double>(stats.total_time).count();
+  auto const execution_time = finish(app, arch, sim, output_dir);
   spdlog::get("log")->info("Done! Execution time is estimated to be {}s.", execution_time);
+}
+
+void estimate(std::string const &manifest_file,
+    std::vector<std::string> const &config_files,
+    std::string const &output_dir,
+    std::size_t jobs,
+    std::string const &fork_at)
+{
+  // Check the configurations before spending time on the traces.
+  // Cores refer to the core types of their architecture, so architectures must not be copied by reallocation.
+  std::vector<arch_m> archs;
+  archs.reserve(config_files.size());
+
+  std::set<std::string> names;
+  for(auto const &config_file : config_files) {
+    if(!names.insert(config_name(config_file)).second) {
+      throw std::runtime_error("Configuration files must have unique names: " + config_file);
+    }
+
+    spdlog::get("log")->info("Loading model configuration file: {}", config_file);
+    archs.push_back(parse_config_file(config_file));
+  }
+  spdlog::get("log")->info("All model configuration files loaded successfully.");
 
-  print(stats, output_dir);
+  sync_m sm{};
+
+  spdlog::get("log")->info("Loading trace manifest file: {}", manifest_file);
+  app_m app = parse_traces(manifest_file, sm);
+  spdlog::get("log")->info("All trace files loaded successfully.");
+
+  log_models(app, sm);
+
+  // When forking, the common prefix of the estimations is only estimated once, with the first configuration.
+  // Otherwise each configuration starts on its own, so that its result does not depend on the order of the others.
+  std::unique_ptr<simulation_m> prefix;
+  if(!fork_at.empty()) {
+    prefix = std::make_unique<simulation_m>(start(app, archs.front(), sm));
+    advance(app, archs.front(), *prefix, parse_stop_condition(fork_at));
+    spdlog::get("log")->info("Forking all configurations at {} ns.", prefix->stats.total_time.count());
+  }
+
+  // Each estimation has its own cursor into the events, so the application is shared by all of them.
+  std::vector<std::future<double>> estimates;
+  thread_pool pool(std::min(jobs > 0 ? jobs : std::thread::hardware_concurrency(), config_files.size()));
+
+  spdlog::get("log")->info("Starting {} estimations with {} workers.", config_files.size(), pool.size());
+  for(std::size_t i = 0; i < config_files.size(); ++i) {
+    auto const config_dir = output_dir + "/" + config_name(config_files[i]);
+    create_directory(config_dir);
+
+    estimates.push_back(pool.submit([&app, &archs, &sm, &prefix, i, config_dir]() {
+      simulation_m sim = prefix ? fork(*prefix, archs.front(), archs[i]) : start(app, archs[i], sm);
+
+      return finish(app, archs[i], sim, config_dir);
+    }));
+  }
+
+  for(std::size_t i = 0; i < config_files.size(); ++i) {
+    auto const execution_time = estimates[i].get();
+    spdlog::get("log")->info("Done! Execution time for {} is estimated to be {}s.", config_files[i], execution_time);
+  }
 }
 
-} // namespace rhythm
\ No newline at end of file
+} // namespace rhythm
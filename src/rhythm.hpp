@@ -1,16 +1,58 @@
 #ifndef RHYTHM_RHYTHM_HPP
 #define RHYTHM_RHYTHM_HPP
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace rhythm {
 
+/**
+ * Where an estimation is saved to or resumed from.
+ */
+struct checkpoint_options {
+  /**
+   * The file to save a checkpoint to, or empty to not save a checkpoint.
+   */
+  std::string save_file;
+
+  /**
+   * When to save the checkpoint: a simulated time in nanoseconds, or "create" for the first thread creation.
+   */
+  std::string save_at;
+
+  /**
+   * The checkpoint to resume the estimation from, or empty to estimate from the start.
+   */
+  std::string resume_file;
+};
+
 /**
  * Estimate performance for an application, system, and architecture.
+ *
+ * @param window If non-zero, stream events from the traces and hold at most this many events per thread in memory.
  */
 void estimate(std::string const &manifest_file,
     std::string const &config_file,
-    std::string const &output_dir);
+    std::string const &output_dir,
+    std::size_t window = 0,
+    checkpoint_options const &checkpoint = {});
+
+/**
+ * Estimate performance for an application on several architectures, loading the traces only once.
+ *
+ * The results for each configuration are written to a subdirectory of the output directory, named after the
+ * configuration file.
+ *
+ * @param jobs The number of configurations to estimate at once, or zero to use one per hardware thread.
+ * @param fork_at If not empty, the point up to which all configurations are estimated as one, using the first
+ * configuration: a simulated time in nanoseconds, or "create" for the first thread creation.
+ */
+void estimate(std::string const &manifest_file,
+    std::vector<std::string> const &config_files,
+    std::string const &output_dir,
+    std::size_t jobs = 0,
+    std::string const &fork_at = "");
 
 } // namespace rhythm
 
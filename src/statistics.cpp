@@ -4,38 +4,131 @@
 
 namespace rhythm {
 
+void add_wait_time(std::vector<time_t> &wait_times, object_t id, time_t const elapsed)
+{
+  if(id >= wait_times.size()) {
+    wait_times.resize(static_cast<std::size_t>(id) + 1, time_t(0));
+  }
+
+  wait_times[id] += elapsed;
+}
+
 void update_blocked_thread(sync_tracker &thread, time_t const elapsed)
 {
   auto const &event = thread.last_event;
 
   switch(event.type) {
   case event_t::lock_acquire:
-    thread.lock_wait_times[thread.last_event.object] += elapsed;
+  case event_t::lock_timeout:
+    add_wait_time(thread.lock_wait_times, event.object, elapsed);
     break;
   case event_t::barrier_wait:
-    thread.barrier_wait_times[thread.last_event.object] += elapsed;
+    add_wait_time(thread.barrier_wait_times, event.object, elapsed);
     break;
   case event_t::condition_wait:
-    thread.condition_wait_times[thread.last_event.object] += elapsed;
+  case event_t::condition_timeout:
+    add_wait_time(thread.condition_wait_times, event.object, elapsed);
+    break;
+  case event_t::rwlock_read_acquire:
+  case event_t::rwlock_write_acquire:
+  case event_t::rwlock_timeout:
+    add_wait_time(thread.rwlock_wait_times, event.object, elapsed);
     break;
   default:
     break;
   }
 }
 
-void update(stats_t &stats, time_t elapsed, event_m const &event, sync_m const &sm)
+/**
+ * Account for the time a core spent at its level since the level was last accounted for.
+ */
+void account_level(stats_t &stats, std::size_t core_id, time_t now)
+{
+  auto &residency = stats.frequency_residency[core_id];
+  std::size_t const level = stats.levels[core_id];
+
+  if(residency.size() <= level) {
+    residency.resize(level + 1, time_t(0));
+  }
+
+  residency[level] += now - stats.level_since[core_id];
+  stats.level_since[core_id] = now;
+}
+
+void update_residency(stats_t &stats, arch_m const &arch, sched_m &sched, time_t now)
+{
+  if(stats.frequency_residency.size() < arch.cores.size()) {
+    stats.frequency_residency.resize(arch.cores.size());
+  }
+
+  // Cores are accounted for from their current level.
+  for(std::size_t core_id = stats.levels.size(); core_id < arch.cores.size(); ++core_id) {
+    stats.levels.push_back(arch.cores[core_id].level);
+    stats.level_since.push_back(now);
+  }
+
+  for(auto const core_id : sched.relevelled_cores) {
+    account_level(stats, core_id, now);
+    stats.levels[core_id] = arch.cores[core_id].level;
+  }
+
+  sched.relevelled_cores.clear();
+}
+
+void flush_residency(stats_t &stats, time_t now)
+{
+  for(std::size_t core_id = 0; core_id < stats.levels.size(); ++core_id) {
+    account_level(stats, core_id, now);
+  }
+}
+
+void update(stats_t &stats, time_t elapsed, sync_m const &sm)
 {
+  if(stats.run_time.size() < sm.threads.size()) {
+    stats.run_time.resize(sm.threads.size(), time_t(0));
+    stats.status_time.resize(sm.threads.size());
+    stats.sync_time.resize(sm.threads.size());
+  }
+
   for(auto const &tid : sm.live_threads) {
-    auto const &thread = sm.threads.at(tid);
-    stats.run_time[tid] += elapsed;
-    stats.status_time[tid].times[thread.status] += elapsed;
+    auto const &thread = sm.threads[thread_index(tid)];
+    stats.run_time[thread_index(tid)] += elapsed;
+    stats.status_time[thread_index(tid)][thread.status] += elapsed;
 
-    if(thread.status == thread_status::blocked) {
-      update_blocked_thread(stats.sync_time[tid], elapsed);
+    if(thread.status == thread_status::blocked || thread.status == thread_status::spinning) {
+      update_blocked_thread(stats.sync_time[thread_index(tid)], elapsed);
     }
   }
+}
+
+void update(stats_t &stats, time_t elapsed, event_m const &event, sync_m const &sm)
+{
+  update(stats, elapsed, sm);
 
-  stats.sync_time[event.thread_id].last_event = event;
+  stats.sync_time.at(thread_index(event.thread_id)).last_event = event;
+}
+
+void update_remote(stats_t &stats, event_m const &event, thread_t thread_id, time_t latency)
+{
+  if(latency == time_t(0)) {
+    return;
+  }
+
+  auto &thread = stats.sync_time.at(thread_index(thread_id));
+
+  switch(event.type) {
+  case event_t::lock_release:
+    add_wait_time(thread.lock_remote_times, event.object, latency);
+    break;
+  case event_t::barrier_wait:
+    add_wait_time(thread.barrier_remote_times, event.object, latency);
+    break;
+  case event_t::rwlock_release:
+    add_wait_time(thread.rwlock_remote_times, event.object, latency);
+    break;
+  default:
+    break;
+  }
 }
 
 void print_time_stacks(stats_t const &stats, std::string const &output_file)
@@ -43,58 +136,98 @@ void print_time_stacks(stats_t const &stats, std::string const &output_file)
   std::ofstream out(output_file);
   out << "TID,status,time\n";
 
-  for(auto const &thread : stats.status_time) {
-    for(auto const &pair : thread.second.times) {
-      auto const status = pair.first;
-      auto const time = std::chrono::duration<double>(pair.second);
+  // Statuses and threads that accumulated no time are not reported.
+  for(std::size_t tid = 0; tid < stats.status_time.size(); ++tid) {
+    for(std::size_t status = 0; status < THREAD_STATUS_COUNT; ++status) {
+      if(stats.status_time[tid].times[status].count() == 0) {
+        continue;
+      }
 
-      out << thread.first << "," << status << "," << time.count() << "\n";
+      auto const time = std::chrono::duration<double>(stats.status_time[tid].times[status]);
+
+      out << tid << "," << static_cast<thread_status>(status) << "," << time.count() << "\n";
     }
   }
 
-  for(auto const &pair : stats.run_time) {
-    auto const time = std::chrono::duration<double>(pair.second);
+  for(std::size_t tid = 0; tid < stats.run_time.size(); ++tid) {
+    if(stats.run_time[tid].count() == 0) {
+      continue;
+    }
 
-    out << pair.first << ",total," << time.count() << "\n";
+    auto const time = std::chrono::duration<double>(stats.run_time[tid]);
+
+    out << tid << ",total," << time.count() << "\n";
+  }
+}
+
+void print_wait_times(std::ostream &out,
+    thread_t thread_id,
+    char const *synchronization,
+    std::vector<time_t> const &wait_times,
+    object_table const &table)
+{
+  for(std::size_t id = 0; id < wait_times.size(); ++id) {
+    if(wait_times[id].count() == 0) {
+      // The thread never waited on this object.
+      continue;
+    }
+
+    address_t const address = table.addresses.at(id);
+    auto const time = std::chrono::duration<double>(wait_times[id]);
+
+    out << thread_id << "," << synchronization << "," << address << "," << time.count() << "\n";
   }
 }
 
-void print_sync_stacks(stats_t const &stats, std::string const &output_file)
+void print_sync_stacks(stats_t const &stats, object_tables const &objects, std::string const &output_file)
 {
   std::ofstream out(output_file);
   out << "TID,synchronization,address,time\n";
 
-  for(auto const &thread_sync: stats.sync_time) {
-    thread_t const thread_id = thread_sync.first;
-    auto const &tracker = thread_sync.second;
-
-    for(auto const &pair: tracker.lock_wait_times) {
-      address_t const address = pair.first;
-      auto const time = std::chrono::duration<double>(pair.second);
+  for(std::size_t tid = 0; tid < stats.sync_time.size(); ++tid) {
+    auto const thread_id = static_cast<thread_t>(tid);
+    auto const &tracker = stats.sync_time[tid];
+
+    print_wait_times(out, thread_id, "lock", tracker.lock_wait_times, objects.locks);
+    print_wait_times(out, thread_id, "barrier-wait", tracker.barrier_wait_times, objects.barriers);
+    print_wait_times(
+        out, thread_id, "condition-wait", tracker.condition_wait_times, objects.condition_variables);
+    print_wait_times(out, thread_id, "rwlock", tracker.rwlock_wait_times, objects.rwlocks);
+    print_wait_times(out, thread_id, "lock-remote", tracker.lock_remote_times, objects.locks);
+    print_wait_times(out, thread_id, "barrier-remote", tracker.barrier_remote_times, objects.barriers);
+    print_wait_times(out, thread_id, "rwlock-remote", tracker.rwlock_remote_times, objects.rwlocks);
+  }
+}
 
-      out << thread_id << ",lock," << address << "," << time.count() << "\n";
-    }
+void print_frequency_residency(stats_t const &stats, arch_m const &arch, std::string const &output_file)
+{
+  std::ofstream out(output_file);
+  out << "core,frequency,time\n";
 
-    for(auto const &pair: tracker.barrier_wait_times) {
-      address_t const address = pair.first;
-      auto const time = std::chrono::duration<double>(pair.second);
+  for(std::size_t core_id = 0; core_id < stats.frequency_residency.size(); ++core_id) {
+    auto const &residency = stats.frequency_residency[core_id];
+    auto const &frequencies = arch.cores.at(core_id).type.frequencies;
 
-      out << thread_id << ",barrier-wait," << address << "," << time.count() << "\n";
-    }
+    for(std::size_t level = 0; level < residency.size(); ++level) {
+      if(residency[level].count() == 0) {
+        continue;
+      }
 
-    for(auto const &pair: tracker.condition_wait_times) {
-      address_t const address = pair.first;
-      auto const time = std::chrono::duration<double>(pair.second);
+      auto const time = std::chrono::duration<double>(residency[level]);
 
-      out << thread_id << ",condition-wait," << address << "," << time.count() << "\n";
+      out << core_id << "," << frequencies.at(level) << "," << time.count() << "\n";
     }
   }
 }
 
-void print(stats_t const &stats, std::string const &output_directory)
+void print(stats_t const &stats,
+    arch_m const &arch,
+    object_tables const &objects,
+    std::string const &output_directory)
 {
   print_time_stacks(stats, output_directory + "/rhythm-time-stacks.csv");
-  print_sync_stacks(stats, output_directory + "/rhythm-sync-stacks.csv");
+  print_sync_stacks(stats, objects, output_directory + "/rhythm-sync-stacks.csv");
+  print_frequency_residency(stats, arch, output_directory + "/rhythm-frequency-residency.csv");
 }
 
 } // namespace rhythm
\ No newline at end of file
@@ -1,8 +1,11 @@
 #ifndef RHYTHM_STATISTICS_HPP
 #define RHYTHM_STATISTICS_HPP
 
-#include <map>
+#include <array>
+#include <vector>
 
+#include "application.hpp"
+#include "architecture.hpp"
 #include "common.hpp"
 #include "synchronization-model.hpp"
 #include "system-model.hpp"
@@ -13,17 +16,34 @@ namespace rhythm {
  * Time spent while in each thread_status.
  */
 struct status_tracker {
-  std::map<thread_status, time_t> times;
+  std::array<time_t, THREAD_STATUS_COUNT> times{};
+
+  time_t &operator[](thread_status status)
+  {
+    return times[static_cast<std::size_t>(status)];
+  }
+
+  time_t operator[](thread_status status) const
+  {
+    return times[static_cast<std::size_t>(status)];
+  }
 };
 
 /**
  * Time spent waiting on different synchronization events.
+ *
+ * Wait times are indexed by the ID of the synchronization object. The remote times are the latency of lock hand-offs
+ * and barrier wake-ups that reached the thread from another socket, after it stopped waiting.
  */
 struct sync_tracker {
   event_m last_event;
-  std::map<address_t, time_t> lock_wait_times;
-  std::map<address_t, time_t> barrier_wait_times;
-  std::map<address_t, time_t> condition_wait_times;
+  std::vector<time_t> lock_wait_times;
+  std::vector<time_t> barrier_wait_times;
+  std::vector<time_t> condition_wait_times;
+  std::vector<time_t> rwlock_wait_times;
+  std::vector<time_t> lock_remote_times;
+  std::vector<time_t> barrier_remote_times;
+  std::vector<time_t> rwlock_remote_times;
 };
 
 /**
@@ -36,30 +56,75 @@ struct stats_t {
   time_t total_time{0};
 
   /**
-   * Total run time of each thread.
+   * Total run time of each thread, indexed by thread ID.
    */
-  std::map<thread_t, time_t> run_time;
+  std::vector<time_t> run_time;
 
   /**
    * The run time per thread, further divided by thread_status.
    */
-  std::map<thread_t, status_tracker> status_time;
+  std::vector<status_tracker> status_time;
 
   /**
    * The waiting time per thread, further divided by the synchronization object being waited on.
    */
-  std::map<thread_t, sync_tracker> sync_time;
+  std::vector<sync_tracker> sync_time;
+
+  /**
+   * The time each core spent at each of its frequency levels, indexed by core ID and then by level.
+   */
+  std::vector<std::vector<time_t>> frequency_residency;
+
+  /**
+   * The level of each core whose residency is not accounted for yet, indexed by core ID.
+   */
+  std::vector<std::size_t> levels;
+
+  /**
+   * Since when the residency of each core at its level is not accounted for, indexed by core ID.
+   */
+  std::vector<time_t> level_since;
 };
 
 /**
  * Update the performance metrics based on how much time has elapsed.
  */
+void update(stats_t &stats, time_t elapsed, sync_m const &sm);
+
+/**
+ * Update the performance metrics based on how much time has elapsed until a thread reached an event.
+ */
 void update(stats_t &stats, time_t elapsed, event_m const &event, sync_m const &sm);
 
+/**
+ * Account for the frequency residency of the cores whose level changed, rather than of every core at every step.
+ *
+ * Cores that are not accounted for yet start at their current level.
+ */
+void update_residency(stats_t &stats, arch_m const &arch, sched_m &sched, time_t now);
+
+/**
+ * Account for the frequency residency of every core up to now, before it is printed or saved.
+ */
+void flush_residency(stats_t &stats, time_t now);
+
+/**
+ * Account for the latency of a wake-up that reached a thread from another socket.
+ *
+ * @param event The event of the thread that woke the other, the release of a lock or reader/writer lock, or a barrier
+ * wait.
+ */
+void update_remote(stats_t &stats, event_m const &event, thread_t thread_id, time_t latency);
+
 /**
  * Print the stats as files to an output directory.
+ *
+ * Synchronization objects are reported by their addresses in the trace.
  */
-void print(stats_t const &stats, std::string const &output_directory);
+void print(stats_t const &stats,
+    arch_m const &arch,
+    object_tables const &objects,
+    std::string const &output_directory);
 
 } // namespace rhythm
 
@@ -7,16 +7,17 @@
 #include "synchronization/barrier.hpp"
 #include "synchronization/condition-variable.hpp"
 #include "synchronization/lock.hpp"
+#include "synchronization/rwlock.hpp"
 
 namespace rhythm {
 
 void add_thread(sync_m &sm, thread_t thread_id)
 {
-  assert(sm.threads.find(thread_id) == sm.threads.end());
+  // Thread IDs are assigned in order of creation.
+  assert(thread_index(thread_id) == sm.threads.size());
 
-  sm.threads.emplace(thread_id, thread_id);
-
-  assert(sm.threads.find(thread_id) != sm.threads.end());
+  sm.threads.emplace_back(thread_id);
+  sm.join_queue.push_back(INVALID_THREAD_ID);
 }
 
 transition_t create(sync_m &sm, thread_t thread_id)
@@ -40,13 +41,15 @@ transition_t join(sync_m &sm, thread_t current_thread, thread_t target_thread)
 {
   transition_t t{};
 
-  auto target_it = sm.finished_threads.find(target_thread);
-  if(target_it == sm.finished_threads.end()) {
+  if(!sm.finished_threads.contains(target_thread)) {
     // The target thread has not finished yet, so the current_thread should wait.
     t.to_sleep.push_back(current_thread);
 
     // Create a dependency so that current_thread will wake up when target_thread finishes.
-    sm.join_queue.emplace(target_thread, current_thread);
+    thread_t &waiting_thread = sm.join_queue.at(target_thread);
+    if(waiting_thread == INVALID_THREAD_ID) {
+      waiting_thread = current_thread;
+    }
   } else {
     // The target thread has already finished, there is no need for the current thread to wait.
   }
@@ -54,28 +57,40 @@ transition_t join(sync_m &sm, thread_t current_thread, thread_t target_thread)
   return t;
 }
 
-transition_t finish(sync_m &sm, thread_t thread_id)
+transition_t finish(sync_m &sm, thread_t thread_id, rwlock_policy preference)
 {
-  assert(sm.finished_threads.find(thread_id) == sm.finished_threads.end());
+  assert(!sm.finished_threads.contains(thread_id));
 
   transition_t t{};
 
   // Check if another thread was waiting on this one to finish.
-  auto const it = sm.join_queue.find(thread_id);
-  if(it != sm.join_queue.end()) {
+  thread_t &waiting_thread = sm.join_queue.at(thread_id);
+  if(waiting_thread != INVALID_THREAD_ID) {
     // Wake up the waiting thread.
-    t.to_wake.push_back(it->second);
+    t.to_wake.push_back(waiting_thread);
 
     // The dependency has been resolved.
-    sm.join_queue.erase(it);
+    waiting_thread = INVALID_THREAD_ID;
   }
 
   auto &thread = sm.threads.at(thread_id);
 
-  for(auto const &held_lock : thread.locks_held) {
+  // Releasing a lock removes it from the set being iterated over.
+  auto const locks_held = thread.locks_held;
+  for(auto const &held_lock : locks_held) {
     spdlog::get("log")->warn("Thread {} finished while holding a lock ({}).", thread_id, held_lock);
 
-    release(sm, thread_id, held_lock);
+    transition_t const released = release(sm, thread_id, held_lock);
+    t.to_wake.insert(t.to_wake.end(), released.to_wake.begin(), released.to_wake.end());
+  }
+
+  // Releasing a reader/writer lock removes it from the set being iterated over, which has an entry for each hold.
+  auto const rwlocks_held = thread.rwlocks_held;
+  for(auto const &held_rwlock : rwlocks_held) {
+    spdlog::get("log")->warn("Thread {} finished while holding a reader/writer lock ({}).", thread_id, held_rwlock);
+
+    transition_t const released = rwlock_release(sm, thread_id, held_rwlock, preference);
+    t.to_wake.insert(t.to_wake.end(), released.to_wake.begin(), released.to_wake.end());
   }
 
   sm.finished_threads.insert(thread_id);
@@ -87,7 +102,43 @@ transition_t finish(sync_m &sm, thread_t thread_id)
   return t;
 }
 
-transition_t synchronize(sync_m &sm, event_m event)
+/**
+ * Block a thread until its timeout expires, the traced wait timed out so the thread does not acquire anything.
+ */
+transition_t timed_wait(sync_m &sm, thread_t thread_id, object_t mutex)
+{
+  transition_t t{};
+
+  if(mutex != INVALID_OBJECT_ID) {
+    // A condition wait releases its mutex while it waits.
+    t = release(sm, thread_id, mutex);
+    sm.threads.at(thread_id).timed_mutex = mutex;
+  }
+
+  t.to_sleep.push_back(thread_id);
+
+  return t;
+}
+
+/**
+ * Keep track of the threads that are blocked after a transition.
+ */
+void update_blocked(sync_m &sm, transition_t const &t)
+{
+  for(auto const &thread : t.to_sleep) {
+    sm.blocked_threads.insert(thread);
+  }
+
+  for(auto const &thread : t.to_wake) {
+    sm.blocked_threads.erase(thread);
+  }
+
+  for(auto const &thread : t.to_kill) {
+    sm.blocked_threads.erase(thread);
+  }
+}
+
+transition_t synchronize(sync_m &sm, event_m event, rwlock_policy preference)
 {
   assert(event.type != event_t::unknown);
 
@@ -104,7 +155,7 @@ transition_t synchronize(sync_m &sm, event_m event)
     t = join(sm, event.thread_id, event.target_thread);
     break;
   case event_t::thread_finish:
-    t = finish(sm, event.thread_id);
+    t = finish(sm, event.thread_id, preference);
     break;
   case event_t::lock_acquire:
     t = acquire(sm, event.thread_id, event.object);
@@ -112,6 +163,15 @@ transition_t synchronize(sync_m &sm, event_m event)
   case event_t::lock_release:
     t = release(sm, event.thread_id, event.object);
     break;
+  case event_t::rwlock_read_acquire:
+    t = read_acquire(sm, event.thread_id, event.object, preference);
+    break;
+  case event_t::rwlock_write_acquire:
+    t = write_acquire(sm, event.thread_id, event.object);
+    break;
+  case event_t::rwlock_release:
+    t = rwlock_release(sm, event.thread_id, event.object, preference);
+    break;
   case event_t::barrier_wait:
     t = barrier_wait(sm, event.thread_id, event.object);
     break;
@@ -124,27 +184,47 @@ transition_t synchronize(sync_m &sm, event_m event)
   case event_t::condition_wait:
     t = condition_wait(sm, event.thread_id, event.object, event.object2);
     break;
+  case event_t::lock_timeout:
+  case event_t::rwlock_timeout:
+    t = timed_wait(sm, event.thread_id, INVALID_OBJECT_ID);
+    break;
+  case event_t::condition_timeout:
+    t = timed_wait(sm, event.thread_id, event.object2);
+    break;
   default:
     spdlog::get("log")->warn("Unknown synchronization event.");
     break;
   }
 
-  for(auto const &thread : t.to_sleep) {
-    sm.blocked_threads.insert(thread);
-  }
+  update_blocked(sm, t);
 
-  for(auto const &thread : t.to_wake) {
-    sm.blocked_threads.erase(thread);
-  }
+  return t;
+}
 
-  for(auto const &thread : t.to_kill) {
-    sm.blocked_threads.erase(thread);
+transition_t time_out(sync_m &sm, thread_t thread_id)
+{
+  auto &thread = sm.threads.at(thread_id);
+
+  transition_t t{};
+
+  if(thread.timed_mutex == INVALID_OBJECT_ID) {
+    t.to_wake.push_back(thread_id);
+  } else {
+    transition_t const check_acquire = acquire(sm, thread_id, thread.timed_mutex);
+    thread.timed_mutex = INVALID_OBJECT_ID;
+
+    if(check_acquire.to_sleep.empty()) {
+      // The lock acquire was successful, otherwise the thread wakes up when the lock is handed to it.
+      t.to_wake.push_back(thread_id);
+    }
   }
 
+  update_blocked(sm, t);
+
   return t;
 }
 
-transition_t break_deadlock(sync_m &sm, thread_t thread_id)
+transition_t break_deadlock(sync_m &sm, thread_t thread_id, rwlock_policy preference)
 {
   // All threads are blocked, find the possible threads that we can wake up.
   auto &thread = sm.threads.at(thread_id);
@@ -154,7 +234,7 @@ transition_t break_deadlock(sync_m &sm, thread_t thread_id)
 
   auto possibility_it = thread.safety_net.begin();
   for(; possibility_it != thread.safety_net.end(); possibility_it++) {
-    if(sm.live_threads.find(possibility_it->first) != sm.live_threads.end()) {
+    if(sm.live_threads.contains(possibility_it->first)) {
       break;
     }
   }
@@ -163,7 +243,7 @@ transition_t break_deadlock(sync_m &sm, thread_t thread_id)
     throw std::runtime_error("All threads are blocked and there are no live options.");
   }
 
-  return synchronize(sm, possibility_it->second);
+  return synchronize(sm, possibility_it->second, preference);
 }
 
 } // namespace rhythm
\ No newline at end of file
@@ -1,13 +1,14 @@
 #ifndef RHYTHM_SYNCHRONIZATION_MODEL_HPP
 #define RHYTHM_SYNCHRONIZATION_MODEL_HPP
 
+#include <cassert>
 #include <cstdint>
 #include <deque>
-#include <map>
-#include <set>
+#include <vector>
 
 #include "common.hpp"
 #include "system-model.hpp"
+#include "thread-set.hpp"
 
 #include "spdlog/fmt/ostr.h"
 
@@ -17,14 +18,10 @@ namespace rhythm {
  * A model for barrier synchronization.
  */
 struct barrier_m {
-  explicit barrier_m(std::size_t total_threads) : count(total_threads)
-  {
-  }
-
   /**
-   * The number of threads that need to reach the barrier.
+   * The number of threads that need to reach the barrier, or zero if the barrier has not been initialized.
    */
-  std::size_t count;
+  std::size_t count = 0;
 
   /**
    * Threads waiting on this barrier, in order of arrival.
@@ -36,10 +33,15 @@ struct barrier_m {
  * A model for condition variable synchronization.
  */
 struct condition_variable_m {
+  /**
+   * Whether the condition variable has been added to the synchronization model.
+   */
+  bool initialized = false;
+
   /**
    * The threads that signal on this condition variable.
    */
-  std::set<thread_t> signallers;
+  thread_set signallers;
 
   /**
    * The maximum number of signals.
@@ -49,7 +51,7 @@ struct condition_variable_m {
   /**
    * The threads that broadcast on this condition variable.
    */
-  std::set<thread_t> broadcasters;
+  thread_set broadcasters;
 
   /**
    * The maximum number of broadcasts.
@@ -64,7 +66,7 @@ struct condition_variable_m {
   /**
    * The threads that wait on this condition variable.
    */
-  std::set<thread_t> consumers;
+  thread_set consumers;
 
   /**
    * An approximation of internal application state.
@@ -77,15 +79,25 @@ struct condition_variable_m {
   std::deque<thread_t> waiters;
 
   /**
-   * The addresses of locks that need to be re-acquired by the threads in waiters.
+   * The IDs of locks that need to be re-acquired by the threads in waiters.
    */
-  std::deque<address_t> mutexes;
+  std::deque<object_t> mutexes;
 };
 
 /**
  * A model for lock synchronization.
  */
 struct lock_m {
+  /**
+   * Whether the lock has been added to the synchronization model.
+   */
+  bool initialized = false;
+
+  /**
+   * Whether threads wait for this lock by spinning on their cores, rather than by blocking.
+   */
+  bool spin = false;
+
   /**
    * Who is currently holding the lock.
    */
@@ -97,60 +109,119 @@ struct lock_m {
   std::deque<thread_t> waiters;
 };
 
+/**
+ * A thread waiting for a reader/writer lock.
+ */
+struct rwlock_waiter {
+  thread_t thread_id;
+
+  /**
+   * Whether the thread waits to write, rather than to read.
+   */
+  bool writer;
+};
+
+/**
+ * A model for reader/writer lock synchronization.
+ */
+struct rwlock_m {
+  /**
+   * Whether the lock has been added to the synchronization model.
+   */
+  bool initialized = false;
+
+  /**
+   * The number of threads holding the lock for reading.
+   */
+  std::size_t readers = 0;
+
+  /**
+   * Who is currently holding the lock for writing.
+   */
+  thread_t writer = INVALID_THREAD_ID;
+
+  /**
+   * Threads waiting for this lock, in order of arrival.
+   */
+  std::deque<rwlock_waiter> waiters;
+};
+
 /**
  * A synchronization model of, for example, a thread library.
  */
 struct sync_m {
   /**
-   * A model for each thread created.
+   * A model for each thread created, indexed by thread ID.
    */
-  std::map<thread_t, kernel_thread> threads;
+  std::vector<kernel_thread> threads;
 
   /**
    * Threads that have started and not finished.
    */
-  std::set<thread_t> live_threads;
+  thread_set live_threads;
 
   /**
    * Threads that were created but have finished.
    */
-  std::set<thread_t> finished_threads;
+  thread_set finished_threads;
 
   /**
    * Threads that are blocked.
    */
-  std::set<thread_t> blocked_threads;
+  thread_set blocked_threads;
+
+  /**
+   * A model of each barrier, indexed by ID.
+   */
+  std::vector<barrier_m> barriers;
 
   /**
-   * A model of each barrier created.
+   * A model for each condition variable, indexed by ID.
    */
-  std::map<address_t, barrier_m> barriers;
+  std::vector<condition_variable_m> condition_variables;
 
   /**
-   * A model for each condition variable created.
+   * A model for each lock, indexed by ID.
    */
-  std::map<address_t, condition_variable_m> condition_variables;
+  std::vector<lock_m> locks;
 
   /**
-   * A model for each lock created.
+   * A model for each reader/writer lock, indexed by ID.
    */
-  std::map<address_t, lock_m> locks;
+  std::vector<rwlock_m> rwlocks;
 
   /**
-   * Threads that are waiting on others to finish.
+   * The thread waiting on each thread to finish, indexed by the ID of the thread being waited on.
+   *
+   * Threads that nobody is waiting on map to INVALID_THREAD_ID.
    */
-  std::map<thread_t, thread_t> join_queue;
+  std::vector<thread_t> join_queue;
 };
 
+/**
+ * @return The model of an object, growing the models to include the object's ID if needed.
+ */
+template <typename model>
+model &get_model(std::vector<model> &models, object_t id)
+{
+  assert(id != INVALID_OBJECT_ID);
+
+  if(id >= models.size()) {
+    models.resize(static_cast<std::size_t>(id) + 1);
+  }
+
+  return models[id];
+}
+
 /**
  * Add a barrier to the synchronization model.
  */
-void add_barrier(sync_m &sm, address_t address, std::size_t count);
+void add_barrier(sync_m &sm, object_t id, std::size_t count);
 
 /**
  * Add a condition variable to the synchronization model.
  */
-void add_condition_variable(sync_m &sm, address_t address);
+void add_condition_variable(sync_m &sm, object_t id);
 
 /**
  * Update the condition variable model.
@@ -160,7 +231,17 @@ void update_condition_variable(sync_m &sm, event_m event);
 /**
  * Add a lock to the synchronization model.
  */
-void add_lock(sync_m &sm, address_t address);
+void add_lock(sync_m &sm, object_t id);
+
+/**
+ * Add a spin lock to the synchronization model.
+ */
+void add_spinlock(sync_m &sm, object_t id);
+
+/**
+ * Add a reader/writer lock to the synchronization model.
+ */
+void add_rwlock(sync_m &sm, object_t id);
 
 /**
  * Add a thread to the synchronization model.
@@ -173,15 +254,25 @@ void add_thread(sync_m &sm, thread_t thread_id);
  * Maintains the invariants of synchronization to ensure liveness and atomicity.
  *
  * @param event The synchronization event driving the update.
+ * @param preference The policy of reader/writer locks.
+ *
+ * @return The set of threads to be scheduled/slept.
+ */
+transition_t synchronize(sync_m &sm, event_m event, rwlock_policy preference);
+
+/**
+ * End the timed wait of a blocked thread whose timeout expired.
+ *
+ * A thread that timed out on a condition variable re-acquires its mutex before it wakes up.
  *
  * @return The set of threads to be scheduled/slept.
  */
-transition_t synchronize(sync_m &sm, event_m event);
+transition_t time_out(sync_m &sm, thread_t thread_id);
 
 /**
  * Break a deadlock that was caused due to approximating application state.
  */
-transition_t break_deadlock(sync_m &sm, thread_t thread_id);
+transition_t break_deadlock(sync_m &sm, thread_t thread_id, rwlock_policy preference);
 
 template <typename ostream>
 ostream &operator<<(ostream &os, sync_m const &sm)
@@ -190,7 +281,8 @@ ostream &operator<<(ostream &os, sync_m const &sm)
   os << "Threads: " << sm.threads.size() << ", ";
   os << "Barriers: " << sm.barriers.size() << ", ";
   os << "Condition Variables: " << sm.condition_variables.size() << ", ";
-  os << "Locks: " << sm.locks.size();
+  os << "Locks: " << sm.locks.size() << ", ";
+  os << "Reader/Writer Locks: " << sm.rwlocks.size();
 
   return os;
 }
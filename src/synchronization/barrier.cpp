@@ -2,23 +2,24 @@
 
 namespace rhythm {
 
-void add_barrier(sync_m &sm, address_t address, std::size_t count)
+void add_barrier(sync_m &sm, object_t id, std::size_t count)
 {
-  //assert(sm.barriers.find(address) == sm.barriers.end());
   assert(count > 0);
 
-  sm.barriers.emplace(address, count);
+  barrier_m &barrier = get_model(sm.barriers, id);
+  if(barrier.count == 0) {
+    barrier.count = count;
+  }
 
-  assert(sm.barriers.find(address) != sm.barriers.end());
-  assert(sm.barriers.find(address)->second.count == count);
+  assert(barrier.count == count);
 }
 
-transition_t barrier_wait(sync_m &sm, thread_t thread_id, std::uint64_t address)
+transition_t barrier_wait(sync_m &sm, thread_t thread_id, object_t id)
 {
-  auto barrier_it = sm.barriers.find(address);
-  assert(barrier_it != sm.barriers.end());
+  assert(id < sm.barriers.size());
 
-  barrier_m &barrier = barrier_it->second;
+  barrier_m &barrier = sm.barriers[id];
+  assert(barrier.count > 0);
   barrier.waiters.push_back(thread_id);
 
   transition_t t{};
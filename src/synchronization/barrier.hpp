@@ -5,7 +5,7 @@
 
 namespace rhythm {
 
-transition_t barrier_wait(sync_m &sm, thread_t thread_id, std::uint64_t address);
+transition_t barrier_wait(sync_m &sm, thread_t thread_id, object_t id);
 }
 
 #endif //RHYTHM_BARRIER_HPP
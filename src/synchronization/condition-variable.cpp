@@ -7,26 +7,15 @@
 
 namespace rhythm {
 
-std::set<thread_t> find_subset(std::set<thread_t> const &set1, std::set<thread_t> const &set2)
+void add_condition_variable(sync_m &sm, object_t id)
 {
-  std::set<thread_t> subset;
+  condition_variable_m &cv = get_model(sm.condition_variables, id);
+  assert(!cv.initialized);
 
-  std::set_intersection(
-      set1.begin(), set1.end(), set2.begin(), set2.end(), std::inserter(subset, subset.begin()));
-
-  return subset;
+  cv.initialized = true;
 }
 
-void add_condition_variable(sync_m &sm, address_t address)
-{
-  assert(sm.condition_variables.find(address) == sm.condition_variables.end());
-
-  sm.condition_variables.emplace(address, condition_variable_m{});
-
-  assert(sm.condition_variables.find(address) != sm.condition_variables.end());
-}
-
-void update_safety_net(kernel_thread &thread, event_m event, std::set<thread_t> const &consumers)
+void update_safety_net(kernel_thread &thread, event_m event, thread_set const &consumers)
 {
   for(auto const &consumer : consumers) {
     event_m silent_event;
@@ -41,23 +30,20 @@ void update_safety_net(kernel_thread &thread, event_m event, std::set<thread_t>
 
 void update_condition_variable(sync_m &sm, event_m event)
 {
-  if(sm.condition_variables.find(event.object) == sm.condition_variables.end()) {
+  condition_variable_m &cv = get_model(sm.condition_variables, event.object);
+  if(!cv.initialized) {
     spdlog::get("log")->warn("Encountered a condition variable that was not initialized.");
-    sm.condition_variables.emplace(event.object, condition_variable_m{});
+    cv.initialized = true;
   }
 
   if(event.type == event_t::condition_wait) {
-    sm.condition_variables.at(event.object).consumers.insert(event.thread_id);
+    cv.consumers.insert(event.thread_id);
   } else if(event.type == event_t::condition_signal) {
-    auto &cv = sm.condition_variables.at(event.object);
-
     cv.signallers.insert(event.thread_id);
     cv.signal_count++;
 
     update_safety_net(sm.threads.at(event.thread_id), event, cv.consumers);
   } else if(event.type == event_t::condition_broadcast) {
-    auto &cv = sm.condition_variables.at(event.object);
-
     cv.broadcasters.insert(event.thread_id);
     cv.broadcast_count++;
 
@@ -65,17 +51,14 @@ void update_condition_variable(sync_m &sm, event_m event)
   } else {
     throw std::runtime_error("Unknown condition variable event type.");
   }
-
-  assert(sm.condition_variables.find(event.object) != sm.condition_variables.end());
 }
 
-transition_t condition_broadcast(sync_m &sm, thread_t thread_id, std::uint64_t address)
+transition_t condition_broadcast(sync_m &sm, thread_t thread_id, object_t id)
 {
   transition_t t{};
 
-  auto cv_it = sm.condition_variables.find(address);
-  assert(cv_it != sm.condition_variables.end());
-  condition_variable_m &cv = cv_it->second;
+  assert(id < sm.condition_variables.size());
+  condition_variable_m &cv = sm.condition_variables[id];
 
   if(cv.consumers.empty()) {
     return t;
@@ -85,7 +68,7 @@ transition_t condition_broadcast(sync_m &sm, thread_t thread_id, std::uint64_t a
   cv.broadcast_count--;
   cv.last_broadcaster = thread_id;
 
-  auto const live_consumers = find_subset(sm.live_threads, cv.consumers);
+  auto const live_consumers = intersection(sm.live_threads, cv.consumers);
   assert(live_consumers.size() >= cv.waiters.size());
 
   auto production_estimate = live_consumers.size() - cv.waiters.size();
@@ -93,7 +76,7 @@ transition_t condition_broadcast(sync_m &sm, thread_t thread_id, std::uint64_t a
 
   if(!cv.waiters.empty()) {
     auto const priority_thread = cv.waiters.front();
-    address_t const mutex = cv.mutexes.front();
+    object_t const mutex = cv.mutexes.front();
 
     cv.waiters.pop_front();
     cv.mutexes.pop_front();
@@ -120,13 +103,12 @@ transition_t condition_broadcast(sync_m &sm, thread_t thread_id, std::uint64_t a
   return t;
 }
 
-transition_t condition_signal(sync_m &sm, std::uint64_t address)
+transition_t condition_signal(sync_m &sm, object_t id)
 {
   transition_t t{};
 
-  auto cv_it = sm.condition_variables.find(address);
-  assert(cv_it != sm.condition_variables.end());
-  condition_variable_m &cv = cv_it->second;
+  assert(id < sm.condition_variables.size());
+  condition_variable_m &cv = sm.condition_variables[id];
 
   if(cv.consumers.empty()) {
     return t;
@@ -140,7 +122,7 @@ transition_t condition_signal(sync_m &sm, std::uint64_t address)
     cv.production = std::min(cv.consumers.size(), cv.production + 1);
   } else {
     thread_t const waiting_thread = cv.waiters.front();
-    address_t const mutex = cv.mutexes.front();
+    object_t const mutex = cv.mutexes.front();
 
     cv.waiters.pop_front();
     cv.mutexes.pop_front();
@@ -170,21 +152,20 @@ transition_t condition_signal(sync_m &sm, std::uint64_t address)
 
 bool can_wait(sync_m const &sm, condition_variable_m const &cv, thread_t thread_id)
 {
-  auto const live_broadcasters = find_subset(sm.live_threads, cv.broadcasters);
-  auto const live_signallers = find_subset(sm.live_threads, cv.signallers);
+  auto const live_broadcasters = intersection(sm.live_threads, cv.broadcasters);
+  auto const live_signallers = intersection(sm.live_threads, cv.signallers);
 
   if(live_broadcasters.empty() && live_signallers.empty()) {
     // None of the live threads can produce anything, so don't wait.
     return false;
   }
 
-  if(live_broadcasters.size() == 1 &&
-      live_broadcasters.find(thread_id) != live_broadcasters.end()) {
+  if(live_broadcasters.size() == 1 && live_broadcasters.contains(thread_id)) {
     // The only live broadcaster is the thread that called wait.
     return false;
   }
 
-  if(live_signallers.size() == 1 && live_signallers.find(thread_id) != live_signallers.end()) {
+  if(live_signallers.size() == 1 && live_signallers.contains(thread_id)) {
     // The only live signaller is the thread that called wait.
     return false;
   }
@@ -198,13 +179,12 @@ bool can_wait(sync_m const &sm, condition_variable_m const &cv, thread_t thread_
 }
 
 transition_t
-condition_wait(sync_m &sm, thread_t thread_id, std::uint64_t address, std::uint64_t mutex)
+condition_wait(sync_m &sm, thread_t thread_id, object_t id, object_t mutex)
 {
   transition_t t{};
 
-  auto cv_it = sm.condition_variables.find(address);
-  assert(cv_it != sm.condition_variables.end());
-  condition_variable_m &cv = cv_it->second;
+  assert(id < sm.condition_variables.size());
+  condition_variable_m &cv = sm.condition_variables[id];
 
   if(cv.production > 0) {
     // There is no need to wait.
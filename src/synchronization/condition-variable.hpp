@@ -3,12 +3,12 @@
 
 namespace rhythm {
 
-transition_t condition_broadcast(sync_m &sm, thread_t thread_id, std::uint64_t address);
+transition_t condition_broadcast(sync_m &sm, thread_t thread_id, object_t id);
 
-transition_t condition_signal(sync_m &sm, std::uint64_t address);
+transition_t condition_signal(sync_m &sm, object_t id);
 
 transition_t
-condition_wait(sync_m &sm, thread_t thread_id, std::uint64_t address, std::uint64_t mutex);
+condition_wait(sync_m &sm, thread_t thread_id, object_t id, object_t mutex);
 
 } // namespace rhythm
 
@@ -4,52 +4,62 @@
 
 namespace rhythm {
 
-void add_lock(sync_m &sm, address_t address)
+void add_lock(sync_m &sm, object_t id)
 {
-  assert(sm.locks.find(address) == sm.locks.end());
+  lock_m &lock = get_model(sm.locks, id);
+  assert(!lock.initialized);
 
-  sm.locks.emplace(address, lock_m{});
+  lock.initialized = true;
+}
+
+void add_spinlock(sync_m &sm, object_t id)
+{
+  add_lock(sm, id);
 
-  assert(sm.locks.find(address) != sm.locks.end());
+  sm.locks[id].spin = true;
 }
 
-void grant_lock(sync_m &sm, thread_t thread_id, std::uint64_t address)
+void grant_lock(sync_m &sm, thread_t thread_id, object_t id)
 {
-  sm.locks.at(address).held_by = thread_id;
-  sm.threads.at(thread_id).locks_held.insert(address);
+  sm.locks[id].held_by = thread_id;
+  sm.threads.at(thread_id).locks_held.insert(id);
 }
 
-transition_t acquire(sync_m &sm, thread_t thread_id, std::uint64_t address)
+transition_t acquire(sync_m &sm, thread_t thread_id, object_t id)
 {
-  if(sm.locks.find(address) == sm.locks.end()) {
+  if(id >= sm.locks.size() || !sm.locks[id].initialized) {
     spdlog::get("log")->warn("Encountered a lock that was not initialized.");
-    add_lock(sm, address);
+    add_lock(sm, id);
   }
 
   transition_t t{};
-  lock_m &lock = sm.locks.at(address);
+  lock_m &lock = sm.locks[id];
 
   if(lock.held_by == INVALID_THREAD_ID) {
     // No contention.
-    grant_lock(sm, thread_id, address);
+    grant_lock(sm, thread_id, id);
   } else {
     // Contention.
     lock.waiters.push_back(thread_id);
-    t.to_sleep.push_back(thread_id);
+
+    if(lock.spin) {
+      t.to_spin.push_back(thread_id);
+    } else {
+      t.to_sleep.push_back(thread_id);
+    }
   }
 
   return t;
 }
 
-transition_t release(sync_m &sm, thread_t thread_id, std::uint64_t address)
+transition_t release(sync_m &sm, thread_t thread_id, object_t id)
 {
-  auto lock_it = sm.locks.find(address);
-  assert(lock_it != sm.locks.end());
+  assert(id < sm.locks.size());
 
-  lock_m &lock = lock_it->second;
+  lock_m &lock = sm.locks[id];
   assert(lock.held_by == thread_id);
 
-  sm.threads.at(thread_id).locks_held.erase(address);
+  sm.threads.at(thread_id).locks_held.erase(id);
 
   transition_t t{};
   if(lock.waiters.empty()) {
@@ -59,7 +69,7 @@ transition_t release(sync_m &sm, thread_t thread_id, std::uint64_t address)
     // Contention.
     thread_t next_thread_id = lock.waiters.front();
     lock.waiters.pop_front();
-    grant_lock(sm, next_thread_id, address);
+    grant_lock(sm, next_thread_id, id);
 
     t.to_wake.push_back(next_thread_id);
   }
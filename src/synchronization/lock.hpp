@@ -5,9 +5,9 @@
 
 namespace rhythm {
 
-transition_t acquire(sync_m &sm, thread_t thread_id, std::uint64_t address);
+transition_t acquire(sync_m &sm, thread_t thread_id, object_t id);
 
-transition_t release(sync_m &sm, thread_t thread_id, std::uint64_t address);
+transition_t release(sync_m &sm, thread_t thread_id, object_t id);
 
 } // namespace rhythm
 
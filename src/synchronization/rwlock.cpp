@@ -0,0 +1,166 @@
+#include "rwlock.hpp"
+
+#include <algorithm>
+
+#include "spdlog/spdlog.h"
+
+namespace rhythm {
+
+void add_rwlock(sync_m &sm, object_t id)
+{
+  rwlock_m &rwlock = get_model(sm.rwlocks, id);
+  assert(!rwlock.initialized);
+
+  rwlock.initialized = true;
+}
+
+rwlock_m &find_rwlock(sync_m &sm, object_t id)
+{
+  if(id >= sm.rwlocks.size() || !sm.rwlocks[id].initialized) {
+    spdlog::get("log")->warn("Encountered a reader/writer lock that was not initialized.");
+    add_rwlock(sm, id);
+  }
+
+  return sm.rwlocks[id];
+}
+
+bool is_free(rwlock_m const &rwlock)
+{
+  return rwlock.readers == 0 && rwlock.writer == INVALID_THREAD_ID;
+}
+
+bool has_waiting(rwlock_m const &rwlock, bool writer)
+{
+  return std::any_of(rwlock.waiters.begin(), rwlock.waiters.end(),
+      [writer](rwlock_waiter const &waiter) { return waiter.writer == writer; });
+}
+
+void grant_rwlock(sync_m &sm, rwlock_waiter const &waiter, object_t id)
+{
+  rwlock_m &rwlock = sm.rwlocks[id];
+
+  if(waiter.writer) {
+    rwlock.writer = waiter.thread_id;
+  } else {
+    rwlock.readers++;
+  }
+
+  sm.threads.at(waiter.thread_id).rwlocks_held.insert(id);
+}
+
+/**
+ * Hand a free lock to the waiting threads that the policy prefers, either one writer or a group of readers.
+ */
+void grant_waiters(sync_m &sm, object_t id, rwlock_policy preference, transition_t &t)
+{
+  rwlock_m &rwlock = sm.rwlocks[id];
+  assert(is_free(rwlock));
+
+  if(rwlock.waiters.empty()) {
+    return;
+  }
+
+  bool writer_first = false;
+  switch(preference) {
+  case rwlock_policy::reader_preferring:
+    writer_first = !has_waiting(rwlock, false);
+    break;
+  case rwlock_policy::writer_preferring:
+    writer_first = has_waiting(rwlock, true);
+    break;
+  case rwlock_policy::fair:
+  default:
+    writer_first = rwlock.waiters.front().writer;
+    break;
+  }
+
+  std::deque<rwlock_waiter> remaining;
+  for(auto const &waiter : rwlock.waiters) {
+    bool granted = false;
+
+    if(writer_first) {
+      granted = waiter.writer && rwlock.writer == INVALID_THREAD_ID;
+    } else {
+      // Under the fair policy, readers that arrived after a waiting writer keep waiting behind it.
+      granted = !waiter.writer && (preference != rwlock_policy::fair || remaining.empty());
+    }
+
+    if(granted) {
+      grant_rwlock(sm, waiter, id);
+      t.to_wake.push_back(waiter.thread_id);
+    } else {
+      remaining.push_back(waiter);
+    }
+  }
+
+  rwlock.waiters = std::move(remaining);
+}
+
+transition_t read_acquire(sync_m &sm, thread_t thread_id, object_t id, rwlock_policy preference)
+{
+  rwlock_m &rwlock = find_rwlock(sm, id);
+
+  bool can_read = rwlock.writer == INVALID_THREAD_ID;
+  if(preference == rwlock_policy::writer_preferring) {
+    can_read = can_read && !has_waiting(rwlock, true);
+  } else if(preference == rwlock_policy::fair) {
+    can_read = can_read && rwlock.waiters.empty();
+  }
+
+  transition_t t{};
+  if(can_read) {
+    // Readers share the lock.
+    grant_rwlock(sm, rwlock_waiter{thread_id, false}, id);
+  } else {
+    rwlock.waiters.push_back(rwlock_waiter{thread_id, false});
+    t.to_sleep.push_back(thread_id);
+  }
+
+  return t;
+}
+
+transition_t write_acquire(sync_m &sm, thread_t thread_id, object_t id)
+{
+  rwlock_m &rwlock = find_rwlock(sm, id);
+
+  transition_t t{};
+  if(is_free(rwlock)) {
+    // No contention.
+    grant_rwlock(sm, rwlock_waiter{thread_id, true}, id);
+  } else {
+    // Contention.
+    rwlock.waiters.push_back(rwlock_waiter{thread_id, true});
+    t.to_sleep.push_back(thread_id);
+  }
+
+  return t;
+}
+
+transition_t rwlock_release(sync_m &sm, thread_t thread_id, object_t id, rwlock_policy preference)
+{
+  assert(id < sm.rwlocks.size());
+
+  rwlock_m &rwlock = sm.rwlocks[id];
+
+  // A thread may hold a read lock more than once, each release only gives up one of its holds.
+  auto &held = sm.threads.at(thread_id).rwlocks_held;
+  auto const hold = held.find(id);
+  assert(hold != held.end());
+  held.erase(hold);
+
+  if(rwlock.writer == thread_id) {
+    rwlock.writer = INVALID_THREAD_ID;
+  } else {
+    assert(rwlock.readers > 0);
+    rwlock.readers--;
+  }
+
+  transition_t t{};
+  if(is_free(rwlock)) {
+    grant_waiters(sm, id, preference, t);
+  }
+
+  return t;
+}
+
+} // namespace rhythm
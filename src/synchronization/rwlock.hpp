@@ -0,0 +1,16 @@
+#ifndef RHYTHM_RWLOCK_HPP
+#define RHYTHM_RWLOCK_HPP
+
+#include "synchronization-model.hpp"
+
+namespace rhythm {
+
+transition_t read_acquire(sync_m &sm, thread_t thread_id, object_t id, rwlock_policy preference);
+
+transition_t write_acquire(sync_m &sm, thread_t thread_id, object_t id);
+
+transition_t rwlock_release(sync_m &sm, thread_t thread_id, object_t id, rwlock_policy preference);
+
+} // namespace rhythm
+
+#endif //RHYTHM_RWLOCK_HPP
@@ -2,29 +2,209 @@
 
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "governor.hpp"
 
 namespace rhythm {
 
 core_m const &get_core(arch_m const &arch, sched_m const &sched, thread_t thread_id)
 {
-  auto mapping_it = sched.mapping.find(thread_id);
-  assert(mapping_it != sched.mapping.end());
+  assert(thread_index(thread_id) < sched.mapping.size());
+  std::size_t const core_id = sched.mapping[thread_id];
 
-  assert(mapping_it->second < arch.cores.size());
-  core_m const &core = arch.cores[mapping_it->second];
+  assert(core_id < arch.cores.size());
+  core_m const &core = arch.cores[core_id];
 
   return core;
 }
 
-cpi_t get_cpi(arch_m const &arch, sched_m const &sched, thread_t thread_id)
+std::size_t get_physical_core(arch_m const &arch, std::size_t core_id)
+{
+  return core_id / arch.topology.threads_per_core;
+}
+
+std::size_t get_socket(arch_m const &arch, std::size_t core_id)
+{
+  if(arch.topology.cores_per_socket == 0) {
+    return 0;
+  }
+
+  return get_physical_core(arch, core_id) / arch.topology.cores_per_socket;
+}
+
+bool is_idle(sched_m const &sched, std::size_t core_id)
+{
+  assert(core_id < sched.core_threads.size());
+  return sched.core_threads[core_id] == INVALID_THREAD_ID;
+}
+
+/**
+ * @return Whether another hardware thread of the same physical core as a core is busy.
+ */
+bool is_sibling_busy(arch_m const &arch, sched_m const &sched, std::size_t core_id)
+{
+  std::size_t const physical_core = get_physical_core(arch, core_id);
+  assert(physical_core < sched.busy_siblings.size());
+
+  std::size_t const busy = sched.busy_siblings[physical_core];
+  return busy > (is_idle(sched, core_id) ? 0 : 1);
+}
+
+/**
+ * @return The factor by which the CPI of a thread on a core inflates because it shares its physical core.
+ */
+double get_smt_slowdown(arch_m const &arch, sched_m const &sched, std::size_t core_id)
+{
+  if(arch.topology.threads_per_core <= 1 || !is_sibling_busy(arch, sched, core_id)) {
+    return 1.0;
+  }
+
+  return arch.topology.smt_slowdown;
+}
+
+/**
+ * Mark the threads running on the other hardware threads of a core's physical core as remapped, since their CPI
+ * depends on whether the core is busy.
+ */
+void remap_siblings(arch_m const &arch, sched_m &sched, std::size_t core_id)
+{
+  if(arch.topology.threads_per_core <= 1) {
+    return;
+  }
+
+  std::size_t const first = get_physical_core(arch, core_id) * arch.topology.threads_per_core;
+
+  for(std::size_t sibling = first; sibling < first + arch.topology.threads_per_core; ++sibling) {
+    if(sibling != core_id && !is_idle(sched, sibling)) {
+      sched.remapped_threads.insert(sched.core_threads[sibling]);
+    }
+  }
+}
+
+/**
+ * @return Whether a thread that last ran on a core loses its cache state when it runs on another core.
+ */
+bool is_migration(arch_m const &arch, std::size_t last_core, std::size_t core_id)
+{
+  // Hardware threads of the same physical core share its caches.
+  return last_core != INVALID_CORE_ID && get_physical_core(arch, last_core) != get_physical_core(arch, core_id);
+}
+
+double get_bytes_per_instruction(arch_m const &arch, thread_t thread_id)
+{
+  auto const &bytes_per_instruction = arch.memory.bytes_per_instruction;
+  if(thread_index(thread_id) >= bytes_per_instruction.size()) {
+    return 0;
+  }
+
+  return bytes_per_instruction[thread_id];
+}
+
+/**
+ * @return The index of the CPI phase that a thread is in, or the number of phases if it has not reached the first.
+ */
+std::size_t find_phase(cpi_series const &series, thread_cursor const &cursor)
+{
+  auto const &phases = series.phases;
+
+  std::uint64_t const position =
+      series.index == phase_index::instructions ? cursor.retired + cursor.progress : cursor.barriers;
+  if(phases.empty() || position < phases.front().start) {
+    return phases.size();
+  }
+
+  // Threads only move forward, so the phase is usually the one they were last found in, or the next.
+  std::size_t phase = std::min(cursor.phase, phases.size() - 1);
+  while(phase + 1 < phases.size() && phases[phase + 1].start <= position) {
+    ++phase;
+  }
+
+  while(phases[phase].start > position) {
+    --phase;
+  }
+
+  return phase;
+}
+
+cpi_series const *get_cpi_phases(core_t const &type, thread_t thread_id)
+{
+  if(thread_index(thread_id) >= type.cpi_phases.size()) {
+    return nullptr;
+  }
+
+  return &type.cpi_phases[thread_id];
+}
+
+/**
+ * @return The CPI rate of a thread on a type of core at its current progress, or zero if it has no CPI rate.
+ */
+cpi_t get_phase_cpi(core_t const &type, thread_t thread_id, thread_cursor const &cursor)
+{
+  if(thread_index(thread_id) >= type.cpi_rates.size()) {
+    return 0;
+  }
+
+  cpi_series const *series = get_cpi_phases(type, thread_id);
+  if(series != nullptr) {
+    std::size_t const phase = find_phase(*series, cursor);
+
+    if(phase < series->phases.size()) {
+      return series->phases[phase].cpi_rate;
+    }
+  }
+
+  return type.cpi_rates[thread_id];
+}
+
+icount_t enter_phase(arch_m const &arch, sched_m const &sched, app_cursor &cursor, thread_t thread_id)
+{
+  cpi_series const *series = get_cpi_phases(get_core(arch, sched, thread_id).type, thread_id);
+  if(series == nullptr) {
+    return std::numeric_limits<icount_t>::max();
+  }
+
+  auto &position = cursor.threads.at(thread_id);
+  position.phase = find_phase(*series, position);
+
+  std::size_t const next = position.phase < series->phases.size() ? position.phase + 1 : 0;
+  if(series->index != phase_index::instructions || next >= series->phases.size()) {
+    return std::numeric_limits<icount_t>::max();
+  }
+
+  return series->phases[next].start - (position.retired + position.progress);
+}
+
+bool changed_phase(arch_m const &arch, sched_m const &sched, app_cursor const &cursor, thread_t thread_id)
+{
+  cpi_series const *series = get_cpi_phases(get_core(arch, sched, thread_id).type, thread_id);
+  if(series == nullptr) {
+    return false;
+  }
+
+  auto const &position = cursor.threads.at(thread_id);
+  return find_phase(*series, position) != position.phase;
+}
+
+cpi_t get_cpi(arch_m const &arch, sched_m const &sched, app_cursor const &cursor, thread_t thread_id)
 {
   core_m const &core = get_core(arch, sched, thread_id);
 
-  auto cpi_it = core.type.cpi_rates.find(thread_id);
-  assert(cpi_it != core.type.cpi_rates.end());
+  cpi_t cpi = get_phase_cpi(core.type, thread_id, cursor.threads.at(thread_id));
+  assert(cpi > 0);
+
+  cpi *= get_smt_slowdown(arch, sched, sched.mapping[thread_id]);
+
+  std::size_t const socket = get_socket(arch, sched.mapping[thread_id]);
+  if(get_bytes_per_instruction(arch, thread_id) > 0 && socket < sched.slowdown.size()) {
+    cpi *= sched.slowdown[socket];
+  }
 
-  return cpi_it->second;
+  return cpi;
 }
 
 freq_t get_freq(arch_m const &arch, sched_m const &sched, thread_t thread_id)
@@ -34,83 +214,552 @@ freq_t get_freq(arch_m const &arch, sched_m const &sched, thread_t thread_id)
   return core.frequency;
 }
 
-void use_next_core(sched_m &sched, thread_t thread_id)
+void map_thread(sched_m &sched, thread_t thread_id, std::size_t core_id)
+{
+  auto const index = thread_index(thread_id);
+  if(index >= sched.mapping.size()) {
+    sched.mapping.resize(index + 1, INVALID_CORE_ID);
+  }
+
+  sched.mapping[index] = core_id;
+  sched.remapped_threads.insert(thread_id);
+}
+
+void index_cores(sched_m &sched, arch_m const &arch)
+{
+  sched.core_threads.assign(arch.cores.size(), INVALID_THREAD_ID);
+  sched.busy_siblings.assign(arch.cores.empty() ? 0 : get_physical_core(arch, arch.cores.size() - 1) + 1, 0);
+
+  for(auto const &thread_id : sched.running_threads) {
+    std::size_t const core_id = sched.mapping[thread_id];
+
+    sched.core_threads[core_id] = thread_id;
+    sched.busy_siblings[get_physical_core(arch, core_id)]++;
+  }
+
+  sched.remapped_cores.clear();
+  for(std::size_t core_id = 0; core_id < arch.cores.size(); ++core_id) {
+    sched.remapped_cores.push_back(core_id);
+  }
+}
+
+void update_contention(arch_m const &arch, sched_m &sched, app_cursor const &cursor)
+{
+  if(arch.memory.bandwidth <= 0 || sched.remapped_threads.empty()) {
+    return;
+  }
+
+  std::size_t const sockets = get_socket(arch, arch.cores.size() - 1) + 1;
+
+  // The bandwidth each socket would need for its threads to run at their uncontended CPI rates.
+  std::vector<double> demand(sockets, 0);
+  for(auto const &thread_id : sched.running_threads) {
+    if(sched.threads.at(thread_index(thread_id)).spinning) {
+      // A spinning thread only reads the lock from its cache.
+      continue;
+    }
+
+    core_m const &core = get_core(arch, sched, thread_id);
+    cpi_t const cpi = get_phase_cpi(core.type, thread_id, cursor.threads.at(thread_id)) *
+        get_smt_slowdown(arch, sched, sched.mapping[thread_id]);
+    double const instructions_per_second = static_cast<double>(core.frequency) / cpi;
+
+    demand[get_socket(arch, sched.mapping[thread_id])] +=
+        get_bytes_per_instruction(arch, thread_id) * instructions_per_second;
+  }
+
+  sched.slowdown.resize(sockets, 1.0);
+
+  std::vector<bool> changed(sockets, false);
+  for(std::size_t socket = 0; socket < sockets; ++socket) {
+    // Threads that access memory slow down evenly until their demand fits within the bandwidth.
+    double const slowdown = std::max(1.0, demand[socket] / arch.memory.bandwidth);
+
+    changed[socket] = slowdown != sched.slowdown[socket];
+    sched.slowdown[socket] = slowdown;
+  }
+
+  for(auto const &thread_id : sched.running_threads) {
+    if(changed[get_socket(arch, sched.mapping[thread_id])] && get_bytes_per_instruction(arch, thread_id) > 0) {
+      sched.remapped_threads.insert(thread_id);
+    }
+  }
+}
+
+void set_frequency(arch_m &arch, sched_m &sched, std::size_t core_id, std::size_t level)
+{
+  assert(core_id < arch.cores.size());
+  core_m &core = arch.cores[core_id];
+
+  if(core.level == level) {
+    return;
+  }
+
+  core.level = level;
+  core.frequency = core.type.frequencies.at(level);
+  sched.relevelled_cores.push_back(core_id);
+
+  if(!is_idle(sched, core_id)) {
+    sched.remapped_threads.insert(sched.core_threads[core_id]);
+  }
+}
+
+sched_thread &get_sched_thread(sched_m &sched, thread_t thread_id)
+{
+  auto const index = thread_index(thread_id);
+  if(index >= sched.threads.size()) {
+    sched.threads.resize(index + 1);
+  }
+
+  return sched.threads[index];
+}
+
+/**
+ * @return How long a thread stalls for when it migrates to a core.
+ */
+time_t migration_time(arch_m const &arch, std::size_t core_id)
+{
+  // Stalled cycles progress like instructions with a CPI of one.
+  return estimate_time(arch.scheduler.migration_penalty, estimate_rate(1.0, arch.cores.at(core_id).frequency));
+}
+
+/**
+ * @return How long a thread would take to reach its next event on a core, or the maximum time if the thread has no
+ * CPI rate for the type of the core.
+ */
+time_t expected_time(arch_m const &arch,
+    sched_m &sched,
+    thread_t thread_id,
+    thread_cursor const &position,
+    std::size_t core_id,
+    icount_t distance)
+{
+  core_t const &type = arch.cores.at(core_id).type;
+  cpi_t const cpi = get_phase_cpi(type, thread_id, position);
+  if(cpi <= 0) {
+    return time_t::max();
+  }
+
+  freq_t const frequency = placement_frequency(arch, sched, core_id, thread_id);
+  time_t time = estimate_time(distance, estimate_rate(cpi * get_smt_slowdown(arch, sched, core_id), frequency));
+
+  if(is_migration(arch, get_sched_thread(sched, thread_id).last_core, core_id)) {
+    time += migration_time(arch, core_id);
+  }
+
+  return time;
+}
+
+/**
+ * @return The idle core that a thread should run on under the scheduler policy.
+ *
+ * Threads wait in a single run queue, a heap, so picking the next thread is O(log threads) however many are waiting.
+ * Only the idle cores are scanned for it, which keeps the policy order exact across cores. Under fifo without SMT
+ * the first idle core is taken without a scan.
+ */
+std::deque<std::size_t>::iterator select_core(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    kernel_thread const &thread)
 {
   assert(!sched.idle_cores.empty());
 
-  auto const core_id = sched.idle_cores.front();
-  sched.idle_cores.pop_front();
-  sched.mapping[thread_id] = core_id;
+  auto selected = sched.idle_cores.begin();
+  if(arch.scheduler.policy != scheduler_policy::heterogeneous) {
+    // Prefer a physical core that is idle altogether, so that the thread does not share it.
+    if(arch.topology.threads_per_core > 1) {
+      auto const idle = std::find_if(sched.idle_cores.begin(), sched.idle_cores.end(),
+          [&](std::size_t core_id) { return !is_sibling_busy(arch, sched, core_id); });
+
+      if(idle != sched.idle_cores.end()) {
+        selected = idle;
+      }
+    }
+
+    return selected;
+  }
+
+  thread_t const thread_id = thread.id;
+  auto const &position = cursor.threads.at(thread_id);
+  icount_t const distance = get_current_event(app.threads.at(thread_id), position).distance;
+
+  // Threads holding a lock delay the threads waiting for it, so they take the core that gets them to their next event
+  // the soonest. Other threads take the slowest core, which leaves the fast cores to lock holders, and among equally
+  // fast cores the one that gets them to their next event the soonest.
+  bool const critical = !thread.locks_held.empty() || !thread.rwlocks_held.empty();
+
+  time_t soonest = time_t::max();
+  double slowest = 0;
+  for(auto it = sched.idle_cores.begin(); it != sched.idle_cores.end(); ++it) {
+    time_t const time = expected_time(arch, sched, thread_id, position, *it, distance);
+    if(time == time_t::max()) {
+      // The thread has no CPI rate for this type of core.
+      continue;
+    }
+
+    // Instructions per second, before any slowdown from sharing the core.
+    double const speed = static_cast<double>(placement_frequency(arch, sched, *it, thread_id)) /
+        get_phase_cpi(arch.cores[*it].type, thread_id, position);
+
+    bool better = soonest == time_t::max() || time < soonest;
+    if(!critical && soonest != time_t::max() && speed != slowest) {
+      better = speed < slowest;
+    }
+
+    if(better) {
+      selected = it;
+      soonest = time;
+      slowest = speed;
+    }
+  }
+
+  return selected;
+}
+
+void enqueue(sched_m &sched, arch_m const &arch, thread_t thread_id)
+{
+  auto &thread = get_sched_thread(sched, thread_id);
+
+  time_t key{0};
+  if(arch.scheduler.policy == scheduler_policy::fair) {
+    // A thread does not get to make up for the time it spent blocked.
+    thread.runtime = std::max(thread.runtime, sched.min_runtime);
+    key = thread.runtime;
+  }
+
+  sched.runnable_threads.push(runqueue_entry{key, sched.arrivals++, thread_id});
+}
+
+/**
+ * Add the time since a thread was dispatched to its runtime.
+ */
+void account(sched_m &sched, thread_t thread_id, time_t now)
+{
+  auto &thread = get_sched_thread(sched, thread_id);
+
+  // A thread that is still switching in has not run yet.
+  if(now > thread.dispatched) {
+    thread.runtime += now - thread.dispatched;
+    thread.dispatched = now;
+  }
+}
+
+void attach(sched_m &sched, arch_m const &arch)
+{
+  std::vector<bool> available(arch.cores.size(), true);
+
+  for(auto const &thread_id : sched.running_threads) {
+    std::size_t const core_id = sched.mapping[thread_id];
+    if(core_id >= arch.cores.size()) {
+      throw std::runtime_error("Thread " + std::to_string(thread_id) + " is running on core " +
+          std::to_string(core_id) + ", which does not exist in the architecture.");
+    }
+
+    available[core_id] = false;
+    sched.remapped_threads.insert(thread_id);
+  }
+
+  // Keep the order in which cores became idle, so that threads are placed as they would have been.
+  std::deque<std::size_t> idle_cores;
+  for(auto const core_id : sched.idle_cores) {
+    if(core_id < available.size() && available[core_id]) {
+      idle_cores.push_back(core_id);
+      available[core_id] = false;
+    }
+  }
+
+  for(std::size_t core_id = 0; core_id < available.size(); ++core_id) {
+    if(available[core_id]) {
+      idle_cores.push_back(core_id);
+    }
+  }
+
+  sched.idle_cores = std::move(idle_cores);
+  index_cores(sched, arch);
+
+  // Waiting threads keep their order relative to each other until the new policy says otherwise.
+  std::vector<thread_t> waiting;
+  for(; !sched.runnable_threads.empty(); sched.runnable_threads.pop()) {
+    waiting.push_back(sched.runnable_threads.top().thread_id);
+  }
+
+  for(auto const thread_id : waiting) {
+    enqueue(sched, arch, thread_id);
+  }
+}
+
+void use_core(sched_m &sched,
+    arch_m const &arch,
+    thread_t thread_id,
+    std::deque<std::size_t>::iterator core,
+    time_t now)
+{
+  auto const core_id = *core;
+  sched.idle_cores.erase(core);
+  map_thread(sched, thread_id, core_id);
+
+  sched.core_threads[core_id] = thread_id;
+  sched.busy_siblings[get_physical_core(arch, core_id)]++;
+  sched.remapped_cores.push_back(core_id);
 
   sched.running_threads.insert(thread_id);
+
+  auto &thread = get_sched_thread(sched, thread_id);
+  thread.dispatched = std::max(now, thread.ready) + arch.scheduler.context_switch;
+
+  if(is_migration(arch, thread.last_core, core_id)) {
+    thread.dispatched += migration_time(arch, core_id);
+  }
+
+  thread.last_core = core_id;
+  remap_siblings(arch, sched, core_id);
 }
 
-void free_core(sched_m &sched, thread_t thread_id)
+void free_core(sched_m &sched, arch_m const &arch, thread_t thread_id)
 {
-  auto it = sched.mapping.find(thread_id);
-  assert(it != sched.mapping.end());
+  auto const index = thread_index(thread_id);
+  assert(index < sched.mapping.size() && sched.mapping[index] != INVALID_CORE_ID);
 
-  sched.idle_cores.push_back(it->second);
-  sched.mapping.erase(it);
+  std::size_t const core_id = sched.mapping[index];
+  sched.idle_cores.push_back(core_id);
+  map_thread(sched, thread_id, INVALID_CORE_ID);
+
+  sched.core_threads[core_id] = INVALID_THREAD_ID;
+  sched.busy_siblings[get_physical_core(arch, core_id)]--;
+  sched.remapped_cores.push_back(core_id);
+  remap_siblings(arch, sched, core_id);
 }
 
-void wake_up(sched_m &sched, kernel_thread &thread)
+void wake_up(sched_m &sched, arch_m const &arch, kernel_thread &thread)
 {
   thread_t const thread_id = thread.id;
 
-  assert(sched.running_threads.find(thread_id) == sched.running_threads.end());
+  auto &waiting = get_sched_thread(sched, thread_id);
+  if(waiting.spinning) {
+    // The thread acquires the lock it was spinning on, without giving up its core or its place in the run queue.
+    waiting.spinning = false;
+    waiting.spin_end = time_t::max();
+
+    if(sched.running_threads.contains(thread_id)) {
+      thread.status = thread_status::running;
+      sched.remapped_threads.insert(thread_id);
+    }
+
+    return;
+  }
 
-  sched.runnable_threads.push_back(thread_id);
+  assert(!sched.running_threads.contains(thread_id));
+
+  enqueue(sched, arch, thread_id);
   thread.status = thread_status::runnable;
 }
 
-void sleep(sched_m &sched, kernel_thread &thread)
+void sleep(sched_m &sched, kernel_thread &thread, time_t now)
 {
   thread_t const thread_id = thread.id;
 
-  assert(sched.running_threads.find(thread_id) != sched.running_threads.end());
+  assert(sched.running_threads.contains(thread_id));
 
+  account(sched, thread_id, now);
   sched.running_threads.erase(thread_id);
   thread.status = thread_status::blocked;
 
-  assert(sched.running_threads.find(thread_id) == sched.running_threads.end());
+  assert(!sched.running_threads.contains(thread_id));
 }
 
-void kill(sched_m &sched, kernel_thread &thread)
+void kill(sched_m &sched, kernel_thread &thread, time_t now)
 {
   thread_t const thread_id = thread.id;
 
   assert(thread.status == thread_status::finished);
-  assert(sched.running_threads.find(thread_id) != sched.running_threads.end());
+  assert(sched.running_threads.contains(thread_id));
 
+  account(sched, thread_id, now);
   sched.running_threads.erase(thread_id);
 }
 
-void schedule(sched_m &sched, std::map<thread_t, kernel_thread> &threads, transition_t const &t)
+/**
+ * Assign waiting threads to idle cores until one of them runs out.
+ */
+void dispatch(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    time_t now)
+{
+  while(!sched.idle_cores.empty() && !sched.runnable_threads.empty()) {
+    runqueue_entry const next = sched.runnable_threads.top();
+    assert(thread_index(next.thread_id) < threads.size());
+
+    use_core(sched, arch, next.thread_id, select_core(sched, arch, app, cursor, threads.at(next.thread_id)), now);
+    threads.at(next.thread_id).status =
+        sched.threads.at(thread_index(next.thread_id)).spinning ? thread_status::spinning : thread_status::running;
+    sched.runnable_threads.pop();
+
+    if(arch.scheduler.policy == scheduler_policy::fair) {
+      sched.min_runtime = std::max(sched.min_runtime, next.key);
+    }
+  }
+}
+
+bool should_preempt(sched_m const &sched, arch_m const &arch, thread_t thread_id)
+{
+  if(sched.runnable_threads.empty()) {
+    return false;
+  }
+
+  if(arch.scheduler.policy == scheduler_policy::fair) {
+    return sched.runnable_threads.top().key < sched.threads.at(thread_index(thread_id)).runtime;
+  }
+
+  return true;
+}
+
+void schedule(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    transition_t const &t,
+    time_t now)
 {
   for(auto const &thread_id : t.to_wake) {
-    wake_up(sched, threads.at(thread_id));
+    wake_up(sched, arch, threads.at(thread_id));
   }
 
   for(auto const &thread_id : t.to_sleep) {
-    sleep(sched, threads.at(thread_id));
+    sleep(sched, threads.at(thread_id), now);
 
-    free_core(sched, thread_id);
+    free_core(sched, arch, thread_id);
   }
 
   for(auto const &thread_id : t.to_kill) {
-    kill(sched, threads.at(thread_id));
+    kill(sched, threads.at(thread_id), now);
 
-    free_core(sched, thread_id);
+    free_core(sched, arch, thread_id);
   }
 
-  while(!sched.idle_cores.empty() && !sched.runnable_threads.empty()) {
-    thread_t const thread_id = sched.runnable_threads.front();
-    assert(threads.find(thread_id) != threads.end());
+  for(auto const &thread_id : t.to_spin) {
+    spin(sched, threads.at(thread_id), time_t::max());
+  }
+
+  dispatch(sched, arch, app, cursor, threads, now);
+}
+
+void expire(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    thread_t thread_id,
+    time_t now)
+{
+  assert(sched.running_threads.contains(thread_id));
+
+  account(sched, thread_id, now);
 
-    use_next_core(sched, thread_id);
-    threads.at(thread_id).status = thread_status::running;
-    sched.runnable_threads.pop_front();
+  // The thread continues from where its time slice ended, either on the same core or later on another.
+  sched.remapped_threads.insert(thread_id);
+
+  if(!should_preempt(sched, arch, thread_id)) {
+    return;
   }
+
+  sched.running_threads.erase(thread_id);
+  free_core(sched, arch, thread_id);
+  enqueue(sched, arch, thread_id);
+  threads.at(thread_id).status = thread_status::preempted;
+
+  dispatch(sched, arch, app, cursor, threads, now);
+}
+
+void spin(sched_m &sched, kernel_thread &thread, time_t until)
+{
+  assert(sched.running_threads.contains(thread.id));
+
+  auto &spinning = get_sched_thread(sched, thread.id);
+  spinning.spinning = true;
+  spinning.spin_end = until;
+
+  thread.status = thread_status::spinning;
+  sched.remapped_threads.insert(thread.id);
+}
+
+bool is_spinning(sched_m const &sched, thread_t thread_id)
+{
+  return thread_index(thread_id) < sched.threads.size() && sched.threads[thread_id].spinning;
+}
+
+time_t spin_end(sched_m const &sched, thread_t thread_id)
+{
+  return sched.threads.at(thread_index(thread_id)).spin_end;
+}
+
+void stop_spinning(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    thread_t thread_id,
+    time_t now)
+{
+  auto &spinning = get_sched_thread(sched, thread_id);
+  assert(spinning.spinning);
+
+  spinning.spinning = false;
+  spinning.spin_end = time_t::max();
+
+  sleep(sched, threads.at(thread_id), now);
+  free_core(sched, arch, thread_id);
+
+  dispatch(sched, arch, app, cursor, threads, now);
+}
+
+time_t remote_latency(arch_m const &arch, sched_m const &sched, thread_t waker, thread_t wakee)
+{
+  assert(thread_index(waker) < sched.mapping.size() && sched.mapping[waker] != INVALID_CORE_ID);
+
+  if(thread_index(wakee) >= sched.threads.size()) {
+    return time_t(0);
+  }
+
+  std::size_t const last_core = sched.threads[wakee].last_core;
+  if(last_core == INVALID_CORE_ID || get_socket(arch, last_core) == get_socket(arch, sched.mapping[waker])) {
+    return time_t(0);
+  }
+
+  return arch.topology.remote_latency;
+}
+
+void delay(sched_m &sched, thread_t thread_id, time_t until)
+{
+  auto &thread = get_sched_thread(sched, thread_id);
+  thread.ready = std::max(thread.ready, until);
+
+  if(sched.running_threads.contains(thread_id)) {
+    // The thread progresses from its ready time, it does not give up its core.
+    sched.remapped_threads.insert(thread_id);
+  }
+}
+
+time_t switched_in(sched_m const &sched, thread_t thread_id)
+{
+  if(thread_index(thread_id) < sched.threads.size()) {
+    return std::max(sched.threads[thread_id].dispatched, sched.threads[thread_id].ready);
+  }
+
+  return time_t(0);
+}
+
+time_t slice_end(arch_m const &arch, sched_m const &sched, thread_t thread_id)
+{
+  if(arch.scheduler.time_slice == time_t(0)) {
+    return time_t::max();
+  }
+
+  // A delay does not extend the time slice of a thread.
+  return sched.threads.at(thread_index(thread_id)).dispatched + arch.scheduler.time_slice;
 }
-} // namespace rhythm
\ No newline at end of file
+} // namespace rhythm
@@ -2,11 +2,18 @@
 #define RHYTHM_SYSTEM_MODEL_HPP
 
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <map>
+#include <limits>
+#include <queue>
 #include <set>
+#include <vector>
 
+#include "application.hpp"
 #include "architecture.hpp"
 #include "common.hpp"
+#include "thread-set.hpp"
 
 namespace rhythm {
 
@@ -30,12 +37,25 @@ enum class thread_status {
    * When a thread is waiting for another thread to wake it up.
    */
   blocked,
+  /**
+   * When a thread is waiting for a lock while it keeps running on its core.
+   */
+  spinning,
+  /**
+   * When a thread is waiting to run on a core again after its time slice expired.
+   */
+  preempted,
   /**
    * When a thread has no more events.
    */
   finished,
 };
 
+/**
+ * The number of values in thread_status.
+ */
+constexpr std::size_t THREAD_STATUS_COUNT = 7;
+
 /**
  * A model of a kernel thread.
  */
@@ -57,11 +77,93 @@ struct kernel_thread {
   /**
    * Locks held by this thread, in order of acquire.
    */
-  std::set<address_t> locks_held;
+  std::set<object_t> locks_held;
+
+  /**
+   * Reader/writer locks held by this thread, for reading or writing, once for each time a read lock is held.
+   */
+  std::multiset<object_t> rwlocks_held;
+
+  /**
+   * The mutex that this thread re-acquires when its timed wait on a condition variable times out.
+   */
+  object_t timed_mutex = INVALID_OBJECT_ID;
 
   std::map<thread_t, event_m> safety_net;
 };
 
+/**
+ * The core ID of a thread that is not mapped to a core.
+ */
+constexpr std::size_t INVALID_CORE_ID = std::numeric_limits<std::size_t>::max();
+
+/**
+ * A thread waiting in the run queue for a core.
+ */
+struct runqueue_entry {
+  /**
+   * The priority of the thread under the scheduler policy, the lowest key runs first.
+   */
+  time_t key;
+
+  /**
+   * When the thread entered the run queue, relative to the other threads.
+   */
+  std::uint64_t arrival;
+
+  thread_t thread_id;
+};
+
+/**
+ * Order entries by key, breaking ties with the earliest arrival.
+ */
+inline bool operator>(runqueue_entry const &lhs, runqueue_entry const &rhs)
+{
+  if(lhs.key != rhs.key) {
+    return lhs.key > rhs.key;
+  }
+
+  return lhs.arrival > rhs.arrival;
+}
+
+/**
+ * The time a thread has spent on a core, as seen by the scheduler.
+ */
+struct sched_thread {
+  /**
+   * The time the thread has spent running, up to when it was last dispatched.
+   *
+   * Under the fair policy, a thread that was blocked starts from the lowest runtime of the running threads.
+   */
+  time_t runtime{0};
+
+  /**
+   * When the thread last started to run on a core after switching in, or had its time slice renewed.
+   */
+  time_t dispatched{0};
+
+  /**
+   * The core that the thread last ran on.
+   */
+  std::size_t last_core = INVALID_CORE_ID;
+
+  /**
+   * When the thread can progress after a synchronization cost, such as the latency of its last wake-up or the time it
+   * takes to acquire a lock.
+   */
+  time_t ready{0};
+
+  /**
+   * Whether the thread is waiting for a lock by spinning, in which case it makes no progress while it is on a core.
+   */
+  bool spinning = false;
+
+  /**
+   * When a spinning thread gives up and blocks, or the maximum time if it spins until it acquires the lock.
+   */
+  time_t spin_end = time_t::max();
+};
+
 /**
  * A model of an operating system scheduler.
  */
@@ -69,28 +171,93 @@ struct sched_m {
   /**
    * The IDs of threads that are running on cores.
    */
-  std::set<thread_t> running_threads;
+  thread_set running_threads;
+
+  /**
+   * The threads that can run but are not assigned to a core, ordered by the scheduler policy.
+   */
+  std::priority_queue<runqueue_entry, std::vector<runqueue_entry>, std::greater<runqueue_entry>> runnable_threads;
+
+  /**
+   * The number of times a thread has entered the run queue.
+   */
+  std::uint64_t arrivals = 0;
+
+  /**
+   * The lowest runtime of a thread dispatched under the fair policy.
+   */
+  time_t min_runtime{0};
 
   /**
-   * The IDs of threads that can run but are not assigned to a core, in order of arrival.
+   * The time each thread has spent on a core, indexed by thread ID.
    */
-  std::deque<thread_t> runnable_threads;
+  std::vector<sched_thread> threads;
 
   /**
-   * The assignments of running threads to cores.
+   * The core assigned to each thread, indexed by thread ID.
+   *
+   * Threads that are not running are assigned INVALID_CORE_ID.
    */
-  std::map<thread_t, std::size_t> mapping;
+  std::vector<std::size_t> mapping;
 
   /**
    * The IDs of cores that are idle.
    */
   std::deque<std::size_t> idle_cores;
+
+  /**
+   * The thread running on each core, indexed by core ID.
+   *
+   * Idle cores are assigned INVALID_THREAD_ID.
+   */
+  std::vector<thread_t> core_threads;
+
+  /**
+   * The number of busy hardware threads of each physical core, indexed by physical core ID.
+   */
+  std::vector<std::size_t> busy_siblings;
+
+  /**
+   * The IDs of cores that a thread was mapped to or removed from since the governor last considered them.
+   */
+  std::vector<std::size_t> remapped_cores;
+
+  /**
+   * The IDs of cores whose frequency level changed since the statistics last accounted for their residency.
+   */
+  std::vector<std::size_t> relevelled_cores;
+
+  /**
+   * The IDs of threads whose core assignment, or the frequency of whose core, changed since the controller last
+   * accounted for them.
+   */
+  thread_set remapped_threads;
+
+  /**
+   * The factor by which memory bandwidth contention inflates the CPI of threads that access memory, indexed by
+   * socket.
+   */
+  std::vector<double> slowdown;
 };
 
 /**
- * @return The CPI rate at which a thread will progress, based on the core it is running on.
+ * @return The CPI rate at which a thread will progress, based on the core it is running on, its CPI phase, whether it
+ * shares its physical core and the memory bandwidth contention on the socket of that core.
  */
-cpi_t get_cpi(arch_m const &arch, sched_m const &sched, thread_t thread_id);
+cpi_t get_cpi(arch_m const &arch, sched_m const &sched, app_cursor const &cursor, thread_t thread_id);
+
+/**
+ * Find the CPI phase that a running thread is in, and remember it in the thread's cursor.
+ *
+ * @return The instructions until the thread's next CPI phase, or the maximum count if its CPI rate only changes at
+ * events.
+ */
+icount_t enter_phase(arch_m const &arch, sched_m const &sched, app_cursor &cursor, thread_t thread_id);
+
+/**
+ * @return Whether a running thread has moved to a different CPI phase since it last entered one.
+ */
+bool changed_phase(arch_m const &arch, sched_m const &sched, app_cursor const &cursor, thread_t thread_id);
 
 /**
  * @return The frequency of the core on which a thread is running.
@@ -99,8 +266,119 @@ freq_t get_freq(arch_m const &arch, sched_m const &sched, thread_t thread_id);
 
 /**
  * Schedule threads to cores based on the current transitions.
+ *
+ * The application and its cursor tell the scheduler how far each thread is from its next event.
+ */
+void schedule(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    transition_t const &t,
+    time_t now);
+
+/**
+ * End the time slice of a running thread.
+ *
+ * The thread is preempted if the scheduler policy prefers a waiting thread, otherwise it continues with a new time
+ * slice. Either way, the thread is marked as remapped.
+ */
+void expire(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    thread_t thread_id,
+    time_t now);
+
+/**
+ * Keep a running thread on its core while it waits for a lock, until it is woken up or a point in time.
+ *
+ * The thread is marked as remapped, it makes no progress until it is woken up.
+ */
+void spin(sched_m &sched, kernel_thread &thread, time_t until);
+
+/**
+ * @return Whether a thread is waiting for a lock by spinning.
+ */
+bool is_spinning(sched_m const &sched, thread_t thread_id);
+
+/**
+ * @return When a spinning thread gives up and blocks, or the maximum time if it spins until it acquires the lock.
  */
-void schedule(sched_m &sched, std::map<thread_t, kernel_thread> &threads, transition_t const &t);
+time_t spin_end(sched_m const &sched, thread_t thread_id);
+
+/**
+ * Block a spinning thread whose spin window has passed, its core is given to a waiting thread.
+ *
+ * The thread remains a waiter of its lock and is woken up when the lock is handed to it.
+ */
+void stop_spinning(sched_m &sched,
+    arch_m const &arch,
+    app_m const &app,
+    app_cursor const &cursor,
+    std::vector<kernel_thread> &threads,
+    thread_t thread_id,
+    time_t now);
+
+/**
+ * @return How much longer a wake-up from a running thread takes to reach a blocked thread, which is the remote latency
+ * if the blocked thread last ran on a different socket.
+ */
+time_t remote_latency(arch_m const &arch, sched_m const &sched, thread_t waker, thread_t wakee);
+
+/**
+ * Stop a thread from progressing until a point in time.
+ *
+ * A running thread keeps its core and is marked as remapped, a thread that is not running cannot start on a core
+ * until then.
+ */
+void delay(sched_m &sched, thread_t thread_id, time_t until);
+
+/**
+ * @return When a running thread starts to progress, which is later than now while it switches in to its core or is
+ * delayed.
+ */
+time_t switched_in(sched_m const &sched, thread_t thread_id);
+
+/**
+ * @return When the time slice of a running thread expires, or the maximum time if the scheduler does not preempt.
+ */
+time_t slice_end(arch_m const &arch, sched_m const &sched, thread_t thread_id);
+
+/**
+ * Assign a thread to a core.
+ */
+void map_thread(sched_m &sched, thread_t thread_id, std::size_t core_id);
+
+/**
+ * Rebuild the thread running on each core, and the number of busy hardware threads of each physical core, from the
+ * cores of the running threads.
+ *
+ * Every core is marked as remapped, so that the governor considers it again.
+ */
+void index_cores(sched_m &sched, arch_m const &arch);
+
+/**
+ * Recompute the memory bandwidth contention on each socket after threads were remapped.
+ *
+ * Running threads that access memory on a socket whose contention changed are marked as remapped, so that they
+ * progress at their new CPI rate.
+ */
+void update_contention(arch_m const &arch, sched_m &sched, app_cursor const &cursor);
+
+/**
+ * Change the frequency level of a core, the thread running on it (if any) will progress at a new rate.
+ */
+void set_frequency(arch_m &arch, sched_m &sched, std::size_t core_id, std::size_t level);
+
+/**
+ * Move the scheduler onto a different architecture, for example when an estimation is forked.
+ *
+ * Running threads keep their cores, which must exist in the new architecture, and continue at the rate of those
+ * cores from now on. Waiting threads are ordered again by the scheduler policy of the new architecture.
+ */
+void attach(sched_m &sched, arch_m const &arch);
 
 template <typename ostream>
 ostream &operator<<(ostream &os, thread_status const &status)
@@ -115,6 +393,12 @@ ostream &operator<<(ostream &os, thread_status const &status)
   case thread_status::blocked:
     os << "blocked";
     break;
+  case thread_status::spinning:
+    os << "spinning";
+    break;
+  case thread_status::preempted:
+    os << "preempted";
+    break;
   case thread_status::finished:
     os << "finished";
     break;
@@ -0,0 +1,55 @@
+#include "thread-pool.hpp"
+
+#include <algorithm>
+
+namespace rhythm {
+
+thread_pool::thread_pool(std::size_t thread_count)
+{
+  if(thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  workers_.reserve(thread_count);
+  for(std::size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(&thread_pool::work, this);
+  }
+}
+
+thread_pool::~thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+
+  available_.notify_all();
+
+  for(auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void thread_pool::work()
+{
+  while(true) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      available_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+      if(tasks_.empty()) {
+        // Only reached when stopping, once every queued task has been taken.
+        return;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+
+} // namespace rhythm
@@ -0,0 +1,84 @@
+#ifndef RHYTHM_THREAD_POOL_HPP
+#define RHYTHM_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rhythm {
+
+/**
+ * A fixed set of worker threads that execute tasks in order of submission.
+ */
+class thread_pool {
+public:
+  /**
+   * Start the worker threads.
+   *
+   * @param thread_count The number of workers, or zero to use one worker per hardware thread.
+   */
+  explicit thread_pool(std::size_t thread_count = 0);
+
+  thread_pool(thread_pool const &) = delete;
+
+  thread_pool &operator=(thread_pool const &) = delete;
+
+  /**
+   * Wait for all submitted tasks to complete and stop the worker threads.
+   */
+  ~thread_pool();
+
+  /**
+   * Queue a task for execution.
+   *
+   * @return A future for the result of the task. Exceptions thrown by the task are rethrown by the future.
+   */
+  template <typename Task>
+  auto submit(Task task) -> std::future<decltype(task())>
+  {
+    using result_t = decltype(task());
+
+    auto packaged = std::make_shared<std::packaged_task<result_t()>>(std::move(task));
+    auto result = packaged->get_future();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back([packaged]() { (*packaged)(); });
+    }
+
+    available_.notify_one();
+
+    return result;
+  }
+
+  /**
+   * @return The number of worker threads.
+   */
+  std::size_t size() const
+  {
+    return workers_.size();
+  }
+
+private:
+  void work();
+
+  std::vector<std::thread> workers_;
+
+  std::deque<std::function<void()>> tasks_;
+
+  std::mutex mutex_;
+
+  std::condition_variable available_;
+
+  bool stopping_ = false;
+};
+
+} // namespace rhythm
+
+#endif //RHYTHM_THREAD_POOL_HPP
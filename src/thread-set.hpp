@@ -0,0 +1,226 @@
+#ifndef RHYTHM_THREAD_SET_HPP
+#define RHYTHM_THREAD_SET_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "common.hpp"
+
+namespace rhythm {
+
+/**
+ * A set of thread IDs, stored as a bitset.
+ *
+ * Thread IDs are dense, so membership tests, insertions and removals are a single bit operation. Iteration visits
+ * threads in ascending order of ID, like std::set.
+ */
+class thread_set {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = thread_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = thread_t const *;
+    using reference = thread_t const &;
+
+    iterator(std::vector<std::uint64_t> const *words, std::size_t bit) : words_(words), bit_(bit)
+    {
+      advance();
+    }
+
+    thread_t const &operator*() const
+    {
+      return current_;
+    }
+
+    iterator &operator++()
+    {
+      ++bit_;
+      advance();
+
+      return *this;
+    }
+
+    bool operator==(iterator const &other) const
+    {
+      return bit_ == other.bit_;
+    }
+
+    bool operator!=(iterator const &other) const
+    {
+      return bit_ != other.bit_;
+    }
+
+  private:
+    void advance()
+    {
+      std::size_t const end = words_->size() * WORD_BITS;
+
+      while(bit_ < end) {
+        std::uint64_t const word = (*words_)[bit_ / WORD_BITS] >> (bit_ % WORD_BITS);
+
+        if(word != 0) {
+          bit_ += trailing_zeros(word);
+          break;
+        }
+
+        // Skip to the start of the next word.
+        bit_ = (bit_ / WORD_BITS + 1) * WORD_BITS;
+      }
+
+      if(bit_ > end) {
+        bit_ = end;
+      }
+
+      current_ = static_cast<thread_t>(bit_);
+    }
+
+    std::vector<std::uint64_t> const *words_;
+
+    std::size_t bit_;
+
+    thread_t current_ = INVALID_THREAD_ID;
+  };
+
+  /**
+   * @return True if the thread was not already in the set.
+   */
+  bool insert(thread_t thread_id)
+  {
+    assert(thread_id >= 0);
+    auto const bit = static_cast<std::size_t>(thread_id);
+
+    if(bit / WORD_BITS >= words_.size()) {
+      words_.resize(bit / WORD_BITS + 1, 0);
+    }
+
+    std::uint64_t &word = words_[bit / WORD_BITS];
+    std::uint64_t const mask = std::uint64_t{1} << (bit % WORD_BITS);
+
+    if((word & mask) != 0) {
+      return false;
+    }
+
+    word |= mask;
+    ++size_;
+
+    return true;
+  }
+
+  /**
+   * @return True if the thread was in the set.
+   */
+  bool erase(thread_t thread_id)
+  {
+    if(!contains(thread_id)) {
+      return false;
+    }
+
+    auto const bit = static_cast<std::size_t>(thread_id);
+    words_[bit / WORD_BITS] &= ~(std::uint64_t{1} << (bit % WORD_BITS));
+    --size_;
+
+    return true;
+  }
+
+  bool contains(thread_t thread_id) const
+  {
+    if(thread_id < 0) {
+      return false;
+    }
+
+    auto const bit = static_cast<std::size_t>(thread_id);
+    if(bit / WORD_BITS >= words_.size()) {
+      return false;
+    }
+
+    return ((words_[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1) != 0;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+  void clear()
+  {
+    std::fill(words_.begin(), words_.end(), 0);
+    size_ = 0;
+  }
+
+  iterator begin() const
+  {
+    return iterator(&words_, 0);
+  }
+
+  iterator end() const
+  {
+    return iterator(&words_, words_.size() * WORD_BITS);
+  }
+
+  /**
+   * @return The threads found in both sets.
+   */
+  friend thread_set intersection(thread_set const &set1, thread_set const &set2)
+  {
+    thread_set result;
+
+    std::size_t const words = std::min(set1.words_.size(), set2.words_.size());
+    result.words_.resize(words, 0);
+
+    for(std::size_t i = 0; i < words; ++i) {
+      result.words_[i] = set1.words_[i] & set2.words_[i];
+      result.size_ += popcount(result.words_[i]);
+    }
+
+    return result;
+  }
+
+private:
+  static constexpr std::size_t WORD_BITS = 64;
+
+  static std::size_t trailing_zeros(std::uint64_t word)
+  {
+    assert(word != 0);
+
+#if defined(__GNUC__)
+    return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+    std::size_t count = 0;
+    for(; (word & 1) == 0; word >>= 1) {
+      ++count;
+    }
+
+    return count;
+#endif
+  }
+
+  static std::size_t popcount(std::uint64_t word)
+  {
+    std::size_t count = 0;
+
+    for(; word != 0; word &= word - 1) {
+      ++count;
+    }
+
+    return count;
+  }
+
+  std::vector<std::uint64_t> words_;
+
+  std::size_t size_ = 0;
+};
+
+} // namespace rhythm
+
+#endif //RHYTHM_THREAD_SET_HPP
@@ -0,0 +1,139 @@
+#include "timeline.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace rhythm {
+
+void place(timeline_m &tl, thread_t thread_id, icount_t instructions, time_t start)
+{
+  auto &thread = tl.threads.at(thread_id);
+  assert(thread.rate > 0);
+
+  thread.version++;
+  thread.active = true;
+  thread.synced = start;
+
+  auto const time = start + estimate_time(instructions, thread.rate);
+  if(thread.deadline < time) {
+    // A time slice can already be over when a thread moves to an architecture with shorter time slices.
+    auto const expiry = std::max(thread.deadline, tl.now);
+    tl.events.push(timeline_event{expiry, thread_id, thread.version, true});
+  } else {
+    tl.events.push(timeline_event{time, thread_id, thread.version, false});
+  }
+}
+
+void insert(timeline_m &tl, thread_t thread_id, icount_t instructions, rate_t rate, time_t start, time_t deadline)
+{
+  if(thread_index(thread_id) >= tl.threads.size()) {
+    tl.threads.resize(thread_index(thread_id) + 1);
+  }
+
+  tl.threads[thread_id].rate = rate;
+  tl.threads[thread_id].deadline = deadline;
+  place(tl, thread_id, instructions, std::max(start, tl.now));
+}
+
+void insert(timeline_m &tl, thread_t thread_id, icount_t instructions)
+{
+  place(tl, thread_id, instructions, tl.now);
+}
+
+void hold(timeline_m &tl, thread_t thread_id, time_t deadline)
+{
+  if(thread_index(thread_id) >= tl.threads.size()) {
+    tl.threads.resize(thread_index(thread_id) + 1);
+  }
+
+  auto &thread = tl.threads[thread_id];
+
+  thread.version++;
+  thread.active = deadline != time_t::max();
+  thread.deadline = deadline;
+
+  // Catching up before the deadline finds that the thread has not progressed.
+  thread.synced = std::max(deadline, tl.now);
+
+  if(thread.active) {
+    tl.events.push(timeline_event{thread.synced, thread_id, thread.version, true});
+  }
+}
+
+void set_timer(timeline_m &tl, thread_t thread_id, time_t time)
+{
+  tl.timers.push(timeline_event{std::max(time, tl.now), thread_id, 0, false, true});
+}
+
+bool has_timers(timeline_m const &tl)
+{
+  return !tl.timers.empty();
+}
+
+void remove(timeline_m &tl, thread_t thread_id)
+{
+  auto &thread = tl.threads.at(thread_id);
+
+  thread.version++;
+  thread.active = false;
+}
+
+bool is_active(timeline_m const &tl, thread_t thread_id)
+{
+  return thread_index(thread_id) < tl.threads.size() && tl.threads[thread_id].active;
+}
+
+icount_t catch_up(timeline_m &tl, thread_t thread_id)
+{
+  auto &thread = tl.threads.at(thread_id);
+  assert(thread.active);
+
+  if(tl.now <= thread.synced) {
+    // The thread is still switching in, it has not progressed yet.
+    return 0;
+  }
+
+  auto const instructions = estimate_instructions(tl.now - thread.synced, thread.rate);
+  thread.synced = tl.now;
+
+  return instructions;
+}
+
+timeline_event pop_next_thread(timeline_m &tl)
+{
+  while(!tl.events.empty() || !tl.timers.empty()) {
+    if(!tl.timers.empty() && (tl.events.empty() || tl.timers.top().time <= tl.events.top().time)) {
+      timeline_event const timer = tl.timers.top();
+      tl.timers.pop();
+
+      assert(timer.time >= tl.now);
+      tl.now = timer.time;
+
+      return timer;
+    }
+
+    timeline_event const event = tl.events.top();
+    tl.events.pop();
+
+    auto &thread = tl.threads.at(event.thread_id);
+    if(event.version != thread.version) {
+      // The thread was re-rated or descheduled after this event was inserted.
+      continue;
+    }
+
+    assert(event.time >= tl.now);
+    tl.now = event.time;
+
+    if(!event.expiry) {
+      // The event has been consumed, the thread needs to be inserted again for its next event.
+      remove(tl, event.thread_id);
+    }
+
+    return event;
+  }
+
+  throw std::runtime_error("There are no running threads on the timeline.");
+}
+
+} // namespace rhythm
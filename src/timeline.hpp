@@ -0,0 +1,186 @@
+#ifndef RHYTHM_TIMELINE_HPP
+#define RHYTHM_TIMELINE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "common.hpp"
+
+namespace rhythm {
+
+/**
+ * The point in time at which a running thread will reach its next synchronization event, or its deadline if that
+ * comes first, or at which the timed wait of a blocked thread times out.
+ */
+struct timeline_event {
+  /**
+   * The absolute time of the event.
+   */
+  time_t time;
+
+  /**
+   * The thread that will reach the event.
+   */
+  thread_t thread_id;
+
+  /**
+   * The version of the thread's entry when this event was inserted.
+   */
+  std::uint64_t version;
+
+  /**
+   * Whether the thread reaches its deadline before its next synchronization event.
+   */
+  bool expiry;
+
+  /**
+   * Whether the event is a timer of a blocked thread, rather than the progress of a running thread.
+   */
+  bool timer = false;
+};
+
+/**
+ * Order events by time, breaking ties with the lowest thread ID.
+ */
+inline bool operator>(timeline_event const &lhs, timeline_event const &rhs)
+{
+  if(lhs.time != rhs.time) {
+    return lhs.time > rhs.time;
+  }
+
+  return lhs.thread_id > rhs.thread_id;
+}
+
+/**
+ * The progress of a thread that is running on a core.
+ *
+ * Threads are not updated as time passes. Instead, the instructions a thread has executed are derived from the
+ * time it was last synchronized and the rate it has been running at since.
+ */
+struct timeline_thread {
+  /**
+   * The current version of the thread's entry.
+   */
+  std::uint64_t version = 0;
+
+  /**
+   * Whether the thread is currently progressing on a core.
+   */
+  bool active = false;
+
+  /**
+   * The last time that the thread's instruction count was brought up to date.
+   *
+   * While a thread switches in to its core, this is the time at which it starts to progress.
+   */
+  time_t synced{0};
+
+  /**
+   * The rate the thread has been running at since it was last synchronized.
+   *
+   * Cached from the CPI and frequency of the thread's core, it only changes when the thread is remapped or the
+   * frequency of its core changes.
+   */
+  rate_t rate = 0;
+
+  /**
+   * When the thread's time slice expires or its CPI rate changes, whichever comes first.
+   */
+  time_t deadline = time_t::max();
+};
+
+/**
+ * A model of when each running thread will reach its next synchronization event.
+ */
+struct timeline_m {
+  /**
+   * The current simulated time.
+   */
+  time_t now{0};
+
+  /**
+   * Upcoming events, earliest first.
+   *
+   * Events are never removed in place. An event is only valid if its version matches the current version of its
+   * thread, outdated events are discarded when they reach the top of the queue.
+   */
+  std::priority_queue<timeline_event, std::vector<timeline_event>, std::greater<timeline_event>> events;
+
+  /**
+   * The timers of blocked threads in a timed wait, earliest first.
+   */
+  std::priority_queue<timeline_event, std::vector<timeline_event>, std::greater<timeline_event>> timers;
+
+  /**
+   * The progress of each thread that has been on the timeline, indexed by thread ID.
+   */
+  std::vector<timeline_thread> threads;
+};
+
+/**
+ * Place a thread on the timeline, replacing any previous entry for the thread.
+ *
+ * @param instructions The number of instructions until the thread's next event.
+ * @param rate The rate the thread will run at from now on.
+ * @param start When the thread starts to progress, if it is still switching in to its core.
+ * @param deadline When the thread's time slice expires or its CPI rate changes, whichever comes first.
+ */
+void insert(timeline_m &tl, thread_t thread_id, icount_t instructions, rate_t rate, time_t start, time_t deadline);
+
+/**
+ * Place a thread on the timeline at the rate, and with the time slice, it was last running with.
+ *
+ * @param instructions The number of instructions until the thread's next event.
+ */
+void insert(timeline_m &tl, thread_t thread_id, icount_t instructions);
+
+/**
+ * Place a thread that is not progressing on its core, for example while it spins on a lock, on the timeline.
+ *
+ * The thread reaches its deadline without executing any instructions. It is removed from the timeline if it has no
+ * deadline.
+ */
+void hold(timeline_m &tl, thread_t thread_id, time_t deadline);
+
+/**
+ * Set a timer for a blocked thread, which pops off the timeline at the given time.
+ */
+void set_timer(timeline_m &tl, thread_t thread_id, time_t time);
+
+/**
+ * @return Whether a blocked thread is waiting for a timer.
+ */
+bool has_timers(timeline_m const &tl);
+
+/**
+ * Remove a thread from the timeline.
+ */
+void remove(timeline_m &tl, thread_t thread_id);
+
+/**
+ * @return Whether the thread is currently progressing on the timeline.
+ */
+bool is_active(timeline_m const &tl, thread_t thread_id);
+
+/**
+ * Bring a thread up to date with the current time.
+ *
+ * @return The number of instructions executed by the thread since it was last synchronized.
+ */
+icount_t catch_up(timeline_m &tl, thread_t thread_id);
+
+/**
+ * Remove the earliest event from the timeline and advance the current time to it.
+ *
+ * A thread that reached its deadline stays active, so that its progress can be caught up. A timer that is due at the
+ * same time as an event is reached first.
+ *
+ * @return The event that was reached.
+ */
+timeline_event pop_next_thread(timeline_m &tl);
+
+} // namespace rhythm
+
+#endif //RHYTHM_TIMELINE_HPP
@@ -0,0 +1,438 @@
+#include "trace-format.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
+#include "zstr.hpp"
+
+namespace rhythm {
+
+namespace {
+
+constexpr char BINARY_MAGIC[8] = {'R', 'H', 'Y', 'T', 'H', 'M', 'B', 'T'};
+
+constexpr std::uint32_t BINARY_VERSION = 2;
+
+std::map<std::string, call_t> const &call_names()
+{
+  static std::map<std::string, call_t> const names = {
+      {"pthread_barrier_init", call_t::pthread_barrier_init},
+      {"pthread_barrier_wait", call_t::pthread_barrier_wait},
+      {"pthread_cond_broadcast", call_t::pthread_cond_broadcast},
+      {"pthread_cond_init", call_t::pthread_cond_init},
+      {"pthread_cond_signal", call_t::pthread_cond_signal},
+      {"pthread_cond_timedwait", call_t::pthread_cond_timedwait},
+      {"pthread_cond_wait", call_t::pthread_cond_wait},
+      {"pthread_create", call_t::pthread_create},
+      {"pthread_join", call_t::pthread_join},
+      {"pthread_mutex_init", call_t::pthread_mutex_init},
+      {"pthread_mutex_lock", call_t::pthread_mutex_lock},
+      {"pthread_mutex_timedlock", call_t::pthread_mutex_timedlock},
+      {"pthread_mutex_trylock", call_t::pthread_mutex_trylock},
+      {"pthread_mutex_unlock", call_t::pthread_mutex_unlock},
+      {"pthread_rwlock_init", call_t::pthread_rwlock_init},
+      {"pthread_rwlock_rdlock", call_t::pthread_rwlock_rdlock},
+      {"pthread_rwlock_timedrdlock", call_t::pthread_rwlock_timedrdlock},
+      {"pthread_rwlock_timedwrlock", call_t::pthread_rwlock_timedwrlock},
+      {"pthread_rwlock_tryrdlock", call_t::pthread_rwlock_tryrdlock},
+      {"pthread_rwlock_trywrlock", call_t::pthread_rwlock_trywrlock},
+      {"pthread_rwlock_unlock", call_t::pthread_rwlock_unlock},
+      {"pthread_rwlock_wrlock", call_t::pthread_rwlock_wrlock},
+      {"pthread_spin_init", call_t::pthread_spin_init},
+      {"pthread_spin_lock", call_t::pthread_spin_lock},
+      {"pthread_spin_trylock", call_t::pthread_spin_trylock},
+      {"pthread_spin_unlock", call_t::pthread_spin_unlock},
+      {"thread_finish", call_t::thread_finish},
+      {"thread_start", call_t::thread_start},
+  };
+
+  return names;
+}
+
+/**
+ * Read a value that older traces do not record, leaving it unchanged if the line has ended.
+ */
+template <typename T>
+void read_optional(std::istream &stream, T &value)
+{
+  if(!stream.eof() && !(stream >> std::ws).eof()) {
+    stream >> value;
+  }
+}
+
+template <typename T>
+T const *at_offset(mapped_file const &file, std::uint64_t offset, std::uint64_t count)
+{
+  if(offset > file.size() || count > (file.size() - offset) / sizeof(T)) {
+    throw std::runtime_error("The binary trace is truncated.");
+  }
+
+  return reinterpret_cast<T const *>(file.data() + offset);
+}
+
+} // namespace
+
+call_t to_call(std::string const &name)
+{
+  auto const &names = call_names();
+
+  auto const it = names.find(name);
+  if(it == names.end()) {
+    return call_t::other;
+  }
+
+  return it->second;
+}
+
+bool is_trylock(call_t call)
+{
+  return call == call_t::pthread_mutex_trylock || call == call_t::pthread_rwlock_tryrdlock ||
+      call == call_t::pthread_rwlock_trywrlock || call == call_t::pthread_spin_trylock;
+}
+
+bool is_timed(call_t call)
+{
+  return call == call_t::pthread_cond_timedwait || call == call_t::pthread_mutex_timedlock ||
+      call == call_t::pthread_rwlock_timedrdlock || call == call_t::pthread_rwlock_timedwrlock;
+}
+
+char const *to_string(call_t call)
+{
+  for(auto const &pair : call_names()) {
+    if(pair.second == call) {
+      return pair.first.c_str();
+    }
+  }
+
+  return "other";
+}
+
+std::istream &operator>>(std::istream &stream, trace_row &row)
+{
+  std::string call;
+
+  stream >> row.thread_id;
+  stream >> call;
+  row.call = to_call(call);
+
+  if(row.call == call_t::pthread_create || row.call == call_t::pthread_join) {
+    stream >> row.handle;
+  } else {
+    stream >> row.arg1;
+  }
+
+  stream >> row.instruction_count;
+
+  if(row.call == call_t::pthread_barrier_init) {
+    stream >> row.barrier_count;
+  } else if(row.call == call_t::pthread_cond_wait || row.call == call_t::pthread_cond_timedwait) {
+    stream >> row.arg2;
+  }
+
+  // Older traces do not record outcomes, so their calls are assumed to have acquired their objects.
+  if(is_trylock(row.call) || is_timed(row.call)) {
+    read_optional(stream, row.result);
+  }
+
+  if(is_timed(row.call)) {
+    read_optional(stream, row.timeout);
+  }
+
+  return stream;
+}
+
+bool read_text_row(std::istream &trace, trace_row &row)
+{
+  std::string line;
+
+  while(std::getline(trace, line) && !line.empty()) {
+    std::istringstream line_stream(line);
+
+    row = trace_row{};
+    if(line_stream >> row) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::vector<trace_row> read_text_trace(std::string const &file)
+{
+  zstr::ifstream trace(file);
+  if(!trace.good()) {
+    throw std::runtime_error("Could not load " + file);
+  }
+
+  std::vector<trace_row> rows;
+
+  trace_row row;
+  while(read_text_row(trace, row)) {
+    rows.push_back(row);
+  }
+
+  return rows;
+}
+
+std::vector<std::string> read_manifest(std::string const &manifest_file)
+{
+  zstr::ifstream manifest(manifest_file);
+  if(!manifest.good()) {
+    throw std::runtime_error("Could not load " + manifest_file);
+  }
+
+  std::vector<std::string> files;
+
+  std::string file;
+  while(manifest >> file) {
+    files.push_back(file);
+  }
+
+  return files;
+}
+
+mapped_file::mapped_file(std::string const &file)
+{
+  int const fd = open(file.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw std::runtime_error("Could not load " + file);
+  }
+
+  struct stat info {};
+  if(fstat(fd, &info) != 0) {
+    close(fd);
+    throw std::runtime_error("Could not determine the size of " + file);
+  }
+
+  size_ = static_cast<std::size_t>(info.st_size);
+
+  if(size_ > 0) {
+    void *address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(address == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Could not map " + file + " into memory");
+    }
+
+    data_ = static_cast<char const *>(address);
+  }
+
+  // The mapping remains valid after the file descriptor is closed.
+  close(fd);
+}
+
+mapped_file::mapped_file(mapped_file &&other) noexcept : data_(other.data_), size_(other.size_)
+{
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+mapped_file::~mapped_file()
+{
+  if(data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+binary_trace::binary_trace(std::string const &file) : file(file)
+{
+  header = at_offset<binary_header>(this->file, 0, 1);
+
+  if(std::memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+    throw std::runtime_error(file + " is not a binary trace.");
+  }
+
+  if(header->version != BINARY_VERSION) {
+    throw std::runtime_error(file + " has an unsupported binary trace version.");
+  }
+
+  rows = at_offset<binary_row>(this->file, header->row_offset, header->row_count);
+  threads = at_offset<binary_thread>(this->file, header->index_offset, header->index_count);
+
+  char const *strings = at_offset<char>(this->file, header->string_offset, header->string_size);
+  char const *const strings_end = strings + header->string_size;
+
+  calls.reserve(header->string_count);
+  for(std::uint32_t i = 0; i < header->string_count; ++i) {
+    auto const length = strnlen(strings, static_cast<std::size_t>(strings_end - strings));
+    if(strings + length == strings_end) {
+      throw std::runtime_error(file + " has a malformed string table.");
+    }
+
+    calls.push_back(to_call(std::string(strings, length)));
+    strings += length + 1;
+  }
+
+  for(std::uint64_t i = 0; i < header->index_count; ++i) {
+    if(threads[i].first_row > header->row_count ||
+        threads[i].row_count > header->row_count - threads[i].first_row) {
+      throw std::runtime_error(file + " has a malformed thread index.");
+    }
+  }
+}
+
+bool is_binary_trace(std::string const &file)
+{
+  std::ifstream stream(file, std::ios::binary);
+
+  char magic[sizeof(BINARY_MAGIC)] = {};
+  stream.read(magic, sizeof(magic));
+
+  return stream.good() && std::memcmp(magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+trace_row decode_row(binary_trace const &trace, binary_thread const &thread, std::uint64_t row_index)
+{
+  assert(row_index < thread.row_count);
+  binary_row const &encoded = trace.rows[thread.first_row + row_index];
+
+  if(encoded.call >= trace.calls.size()) {
+    throw std::runtime_error("A binary trace row refers to an unknown call.");
+  }
+
+  trace_row row;
+
+  row.thread_id = thread.thread_id;
+  row.call = trace.calls[encoded.call];
+  row.instruction_count = encoded.instruction_count;
+  row.barrier_count = encoded.barrier_count;
+  row.arg2 = encoded.arg2;
+  row.result = encoded.result;
+  row.timeout = encoded.timeout;
+
+  if(row.call == call_t::pthread_create || row.call == call_t::pthread_join) {
+    row.handle = encoded.arg1;
+  } else {
+    row.arg1 = encoded.arg1;
+  }
+
+  return row;
+}
+
+namespace {
+
+template <typename T>
+void write_value(std::ostream &out, T const &value)
+{
+  out.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+std::uint32_t intern_call(std::map<call_t, std::uint32_t> &string_ids,
+    std::vector<std::string> &strings,
+    call_t call)
+{
+  auto const it = string_ids.find(call);
+  if(it != string_ids.end()) {
+    return it->second;
+  }
+
+  auto const id = static_cast<std::uint32_t>(strings.size());
+  string_ids.emplace(call, id);
+  strings.emplace_back(to_string(call));
+
+  return id;
+}
+
+} // namespace
+
+void write_binary_trace(std::string const &manifest_file, std::string const &output_file)
+{
+  std::ofstream out(output_file, std::ios::binary | std::ios::trunc);
+  if(!out.good()) {
+    throw std::runtime_error("Could not create " + output_file);
+  }
+
+  // The header is written last, once all offsets are known.
+  binary_header header{};
+  write_value(out, header);
+
+  std::map<call_t, std::uint32_t> string_ids;
+  std::vector<std::string> strings;
+  std::vector<binary_thread> threads;
+
+  header.row_offset = sizeof(binary_header);
+
+  for(auto const &file : read_manifest(manifest_file)) {
+    zstr::ifstream trace(file);
+    if(!trace.good()) {
+      throw std::runtime_error("Could not load " + file);
+    } else {
+      spdlog::get("log")->info("Converting trace file: {}", file);
+    }
+
+    binary_thread thread{};
+    thread.first_row = header.row_count;
+
+    trace_row row;
+    while(read_text_row(trace, row)) {
+      if(thread.row_count > 0 && row.thread_id != thread.thread_id) {
+        throw std::runtime_error(file + " contains rows from more than one thread.");
+      }
+      thread.thread_id = row.thread_id;
+
+      binary_row encoded{};
+
+      encoded.call = intern_call(string_ids, strings, row.call);
+      encoded.barrier_count = static_cast<std::uint32_t>(row.barrier_count);
+      encoded.arg2 = row.arg2;
+      encoded.instruction_count = row.instruction_count;
+      encoded.result = row.result;
+      encoded.timeout = row.timeout;
+
+      if(row.call == call_t::pthread_create || row.call == call_t::pthread_join) {
+        encoded.arg1 = row.handle;
+      } else {
+        encoded.arg1 = row.arg1;
+      }
+
+      write_value(out, encoded);
+
+      thread.row_count++;
+      header.row_count++;
+    }
+
+    threads.push_back(thread);
+  }
+
+  header.string_offset = header.row_offset + header.row_count * sizeof(binary_row);
+  header.string_count = static_cast<std::uint32_t>(strings.size());
+
+  for(auto const &string : strings) {
+    out.write(string.c_str(), static_cast<std::streamsize>(string.size() + 1));
+    header.string_size += string.size() + 1;
+  }
+
+  // Keep the thread index aligned.
+  while(header.string_size % alignof(binary_thread) != 0) {
+    out.put('\0');
+    header.string_size++;
+  }
+
+  header.index_offset = header.string_offset + header.string_size;
+  header.index_count = threads.size();
+
+  for(auto const &thread : threads) {
+    write_value(out, thread);
+  }
+
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  header.version = BINARY_VERSION;
+
+  out.seekp(0);
+  write_value(out, header);
+
+  if(!out.good()) {
+    throw std::runtime_error("Could not write " + output_file);
+  }
+}
+
+} // namespace rhythm
@@ -0,0 +1,265 @@
+#ifndef RHYTHM_TRACE_FORMAT_HPP
+#define RHYTHM_TRACE_FORMAT_HPP
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+namespace rhythm {
+
+// What pthread_t typically is in the pthreads library.
+using pthread_t = unsigned long int;
+
+/**
+ * The function calls that can appear in a trace.
+ */
+enum class call_t : std::uint8_t {
+  pthread_barrier_init,
+  pthread_barrier_wait,
+  pthread_cond_broadcast,
+  pthread_cond_init,
+  pthread_cond_signal,
+  pthread_cond_timedwait,
+  pthread_cond_wait,
+  pthread_create,
+  pthread_join,
+  pthread_mutex_init,
+  pthread_mutex_lock,
+  pthread_mutex_timedlock,
+  pthread_mutex_trylock,
+  pthread_mutex_unlock,
+  pthread_rwlock_init,
+  pthread_rwlock_rdlock,
+  pthread_rwlock_timedrdlock,
+  pthread_rwlock_timedwrlock,
+  pthread_rwlock_tryrdlock,
+  pthread_rwlock_trywrlock,
+  pthread_rwlock_unlock,
+  pthread_rwlock_wrlock,
+  pthread_spin_init,
+  pthread_spin_lock,
+  pthread_spin_trylock,
+  pthread_spin_unlock,
+  thread_finish,
+  thread_start,
+  /**
+   * A call that is recorded by the Pin tool but not used by the model (e.g., pthread_mutex_destroy).
+   */
+  other
+};
+
+/**
+ * @return The call with the given name, or call_t::other if the name is not known.
+ */
+call_t to_call(std::string const &name);
+
+/**
+ * @return The name of a call as it appears in a text trace.
+ */
+char const *to_string(call_t call);
+
+/**
+ * A single row of a trace.
+ */
+struct trace_row {
+  thread_t thread_id = -1;
+  call_t call = call_t::other;
+  pthread_t handle = 0;
+  address_t arg1 = 0;
+  address_t arg2 = 0;
+  std::size_t barrier_count = 0;
+  icount_t instruction_count = 0;
+
+  /**
+   * The return value of a trylock or timed call, zero if the call acquired its object.
+   */
+  std::int64_t result = 0;
+
+  /**
+   * How long (in nanoseconds) a timed call waits before it times out.
+   */
+  std::uint64_t timeout = 0;
+};
+
+/**
+ * @return Whether the call returns instead of blocking when its object is not available.
+ */
+bool is_trylock(call_t call);
+
+/**
+ * @return Whether the call gives up waiting for its object after a timeout.
+ */
+bool is_timed(call_t call);
+
+/**
+ * Read a row from a line of a text trace.
+ */
+std::istream &operator>>(std::istream &stream, trace_row &row);
+
+/**
+ * Read the next row of a text trace.
+ *
+ * @return False once the end of the trace (or an empty line) has been reached.
+ */
+bool read_text_row(std::istream &trace, trace_row &row);
+
+/**
+ * Decompress and tokenize every row of a text trace file.
+ */
+std::vector<trace_row> read_text_trace(std::string const &file);
+
+/**
+ * @return The trace files listed in a manifest, in order.
+ */
+std::vector<std::string> read_manifest(std::string const &manifest_file);
+
+/**
+ * The header of a binary trace.
+ *
+ * A binary trace contains every trace file of a manifest and is laid out as:
+ *
+ *   header | rows | string table | thread index
+ *
+ * Rows are fixed-width and stored contiguously for each trace file. The string table holds the null-terminated
+ * names of the calls referenced by the rows. The thread index lists the rows of each trace file, in the order of
+ * the manifest. All values are stored in the byte order of the machine that wrote the trace.
+ */
+struct binary_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t string_count;
+  std::uint64_t row_offset;
+  std::uint64_t row_count;
+  std::uint64_t string_offset;
+  std::uint64_t string_size;
+  std::uint64_t index_offset;
+  std::uint64_t index_count;
+};
+
+/**
+ * A fixed-width row of a binary trace.
+ */
+struct binary_row {
+  /**
+   * The index of the call's name in the string table.
+   */
+  std::uint32_t call;
+
+  /**
+   * The number of threads for a pthread_barrier_init call.
+   */
+  std::uint32_t barrier_count;
+
+  /**
+   * The synchronization object, or the pthread_t handle for pthread_create and pthread_join.
+   */
+  std::uint64_t arg1;
+
+  /**
+   * The mutex for a pthread_cond_wait or pthread_cond_timedwait call.
+   */
+  std::uint64_t arg2;
+
+  /**
+   * The number of instructions executed by the thread before the call.
+   */
+  std::uint64_t instruction_count;
+
+  /**
+   * The return value of a trylock or timed call.
+   */
+  std::int64_t result;
+
+  /**
+   * The timeout (in nanoseconds) of a timed call.
+   */
+  std::uint64_t timeout;
+};
+
+/**
+ * An entry of the thread index of a binary trace.
+ */
+struct binary_thread {
+  std::int64_t thread_id;
+  std::uint64_t first_row;
+  std::uint64_t row_count;
+};
+
+static_assert(sizeof(binary_header) == 64, "Unexpected padding in the binary trace header.");
+static_assert(sizeof(binary_row) == 48, "Unexpected padding in the binary trace rows.");
+static_assert(sizeof(binary_thread) == 24, "Unexpected padding in the binary trace index.");
+
+/**
+ * A read-only view of a file that has been mapped into memory.
+ */
+class mapped_file {
+public:
+  explicit mapped_file(std::string const &file);
+
+  mapped_file(mapped_file &&other) noexcept;
+
+  mapped_file(mapped_file const &) = delete;
+
+  mapped_file &operator=(mapped_file const &) = delete;
+
+  mapped_file &operator=(mapped_file &&) = delete;
+
+  ~mapped_file();
+
+  char const *data() const
+  {
+    return data_;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  char const *data_ = nullptr;
+
+  std::size_t size_ = 0;
+};
+
+/**
+ * A binary trace that has been mapped into memory.
+ */
+struct binary_trace {
+  explicit binary_trace(std::string const &file);
+
+  mapped_file file;
+
+  binary_header const *header = nullptr;
+
+  binary_row const *rows = nullptr;
+
+  binary_thread const *threads = nullptr;
+
+  /**
+   * The call of each entry in the string table.
+   */
+  std::vector<call_t> calls;
+};
+
+/**
+ * @return True if the file starts with the magic bytes of a binary trace.
+ */
+bool is_binary_trace(std::string const &file);
+
+/**
+ * Decode a row of a binary trace.
+ */
+trace_row decode_row(binary_trace const &trace, binary_thread const &thread, std::uint64_t row_index);
+
+/**
+ * Convert the text traces listed in a manifest into a single binary trace.
+ */
+void write_binary_trace(std::string const &manifest_file, std::string const &output_file);
+
+} // namespace rhythm
+
+#endif //RHYTHM_TRACE_FORMAT_HPP
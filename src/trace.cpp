@@ -1,199 +1,220 @@
 #include "trace.hpp"
 
-#include <set>
-#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
 
 #include "spdlog/spdlog.h"
+
+#include "thread-pool.hpp"
+#include "trace-format.hpp"
 #include "zstr.hpp"
 
 namespace rhythm {
 
-// What pthread_t typically is in the pthreads library.
-using pthread_t = unsigned long int;
-
-struct trace_row {
-  thread_t thread_id = -1;
-  std::string call = "";
-  pthread_t handle = 0;
-  address_t arg1 = 0;
-  address_t arg2 = 0;
-  size_t barrier_count = 0;
-  icount_t instruction_count = 0;
-
-  friend std::istream &operator>>(std::istream &stream, trace_row &row) {
-    stream >> row.thread_id;
-    stream >> row.call;
-
-    if (row.call == "pthread_create" || row.call == "pthread_join") {
-      stream >> row.handle;
-    } else {
-      stream >> row.arg1;
-    }
-
-    stream >> row.instruction_count;
-
-    if (row.call == "pthread_barrier_init") {
-      stream >> row.barrier_count;
-    } else if (row.call == "pthread_cond_wait") {
-      stream >> row.arg2;
-    }
-
-    return stream;
+void intern_objects(trace_row const &row, object_tables &objects) {
+  switch (row.call) {
+  case call_t::pthread_mutex_lock:
+  case call_t::pthread_mutex_timedlock:
+  case call_t::pthread_mutex_trylock:
+  case call_t::pthread_spin_lock:
+  case call_t::pthread_spin_trylock:
+  case call_t::pthread_mutex_unlock:
+  case call_t::pthread_spin_unlock:
+    intern(objects.locks, row.arg1);
+    break;
+  case call_t::pthread_rwlock_wrlock:
+  case call_t::pthread_rwlock_timedwrlock:
+  case call_t::pthread_rwlock_trywrlock:
+  case call_t::pthread_rwlock_rdlock:
+  case call_t::pthread_rwlock_timedrdlock:
+  case call_t::pthread_rwlock_tryrdlock:
+  case call_t::pthread_rwlock_unlock:
+    intern(objects.rwlocks, row.arg1);
+    break;
+  case call_t::pthread_barrier_wait:
+    intern(objects.barriers, row.arg1);
+    break;
+  case call_t::pthread_cond_broadcast:
+  case call_t::pthread_cond_signal:
+    intern(objects.condition_variables, row.arg1);
+    break;
+  case call_t::pthread_cond_wait:
+  case call_t::pthread_cond_timedwait:
+    intern(objects.condition_variables, row.arg1);
+    intern(objects.locks, row.arg2);
+    break;
+  default:
+    break;
   }
-};
-
-event_m create_event(trace_row const &row, sync_m &sm,
-                     std::map<pthread_t, thread_t> &handles,
-                     thread_t &next_create_id) {
-  static std::set<std::string> not_supported = {
-      "pthread_mutex_trylock",
-      "pthread_rwlock_trywrlock",
-      "pthread_rwlock_tryrdlock",
-      "pthread_spin_trylock",
-  };
+}
 
-  if (not_supported.find(row.call) != not_supported.end()) {
-    throw std::runtime_error(row.call + " is not supported.");
+/**
+ * @return A timeout event for a timed call that timed out.
+ */
+event_m to_timeout(trace_row const &row, object_tables const &objects) {
+  event_m timeout;
+
+  timeout.thread_id = row.thread_id;
+  timeout.distance = row.instruction_count;
+  timeout.timeout = time_t(static_cast<time_t::rep>(row.timeout));
+
+  switch (row.call) {
+  case call_t::pthread_mutex_timedlock:
+    timeout.type = event_t::lock_timeout;
+    timeout.object = find(objects.locks, row.arg1);
+    break;
+  case call_t::pthread_rwlock_timedrdlock:
+  case call_t::pthread_rwlock_timedwrlock:
+    timeout.type = event_t::rwlock_timeout;
+    timeout.object = find(objects.rwlocks, row.arg1);
+    break;
+  case call_t::pthread_cond_timedwait:
+    timeout.type = event_t::condition_timeout;
+    timeout.object = find(objects.condition_variables, row.arg1);
+    timeout.object2 = find(objects.locks, row.arg2);
+    break;
+  default:
+    break;
   }
 
-  if (row.call == "pthread_barrier_init") {
-    add_barrier(sm, row.arg1, row.barrier_count);
+  return timeout;
+}
 
+event_m to_event(trace_row const &row, thread_t target_thread,
+                 object_tables const &objects) {
+  if (is_trylock(row.call) && row.result != 0) {
+    // The object was not available, the thread carries on without it.
     return event_m{};
   }
 
-  if (row.call == "pthread_cond_init") {
-    add_condition_variable(sm, row.arg1);
-
-    return event_m{};
+  if (is_timed(row.call) && row.result != 0) {
+    // Other errors are returned without waiting.
+    return row.result == ETIMEDOUT ? to_timeout(row, objects) : event_m{};
   }
 
-  static std::set<std::string> lock_inits = {
-      "pthread_mutex_init",
-      "pthread_rwlock_init",
-      "pthread_spin_init",
-  };
+  switch (row.call) {
+  case call_t::pthread_mutex_lock:
+  case call_t::pthread_mutex_timedlock:
+  case call_t::pthread_mutex_trylock:
+  case call_t::pthread_spin_lock:
+  case call_t::pthread_spin_trylock: {
+    event_m lock;
 
-  if (lock_inits.find(row.call) != lock_inits.end()) {
-    add_lock(sm, row.arg1);
+    lock.thread_id = row.thread_id;
+    lock.type = event_t::lock_acquire;
+    lock.object = find(objects.locks, row.arg1);
+    lock.distance = row.instruction_count;
 
-    return event_m{};
+    return lock;
   }
+  case call_t::pthread_mutex_unlock:
+  case call_t::pthread_spin_unlock: {
+    event_m unlock;
 
-  if (row.call == "pthread_create") {
-    next_create_id++;
-
-    bool was_inserted = false;
-    std::map<pthread_t, thread_t>::iterator handle;
-    std::tie(handle, was_inserted) =
-        handles.emplace(row.handle, next_create_id);
-    if (!was_inserted) {
-      // This can happen if a thread finishes and another pthread_create call
-      // occurs. For now, assume that a join call occurs before the
-      // pthread_create, so we will just overwrite the thread ID for this
-      // handle.
-      handle->second = next_create_id;
-    }
-
-    event_m create;
-
-    create.thread_id = row.thread_id;
-    create.type = event_t::thread_create;
-    create.distance = row.instruction_count;
-    create.target_thread = next_create_id;
-
-    add_thread(sm, next_create_id);
+    unlock.thread_id = row.thread_id;
+    unlock.type = event_t::lock_release;
+    unlock.object = find(objects.locks, row.arg1);
+    unlock.distance = row.instruction_count;
 
-    return create;
+    return unlock;
   }
-
-  static std::set<std::string> lock_calls = {
-      "pthread_mutex_lock",    "pthread_mutex_timedlock",
-      "pthread_rwlock_wrlock", "pthread_rwlock_timedwrlock",
-      "pthread_rwlock_rdlock", "pthread_rwlock_timedrdlock",
-      "pthread_spin_lock",
-  };
-
-  if (lock_calls.find(row.call) != lock_calls.end()) {
+  case call_t::pthread_rwlock_rdlock:
+  case call_t::pthread_rwlock_timedrdlock:
+  case call_t::pthread_rwlock_tryrdlock:
+  case call_t::pthread_rwlock_wrlock:
+  case call_t::pthread_rwlock_timedwrlock:
+  case call_t::pthread_rwlock_trywrlock: {
     event_m lock;
 
+    bool const is_write = row.call == call_t::pthread_rwlock_wrlock ||
+                          row.call == call_t::pthread_rwlock_timedwrlock ||
+                          row.call == call_t::pthread_rwlock_trywrlock;
+
     lock.thread_id = row.thread_id;
-    lock.type = event_t::lock_acquire;
-    lock.object = row.arg1;
+    lock.type = is_write ? event_t::rwlock_write_acquire
+                         : event_t::rwlock_read_acquire;
+    lock.object = find(objects.rwlocks, row.arg1);
     lock.distance = row.instruction_count;
 
     return lock;
   }
-
-  static std::set<std::string> unlock_calls = {
-      "pthread_mutex_unlock",
-      "pthread_rwlock_unlock",
-      "pthread_spin_unlock",
-  };
-
-  if (unlock_calls.find(row.call) != unlock_calls.end()) {
+  case call_t::pthread_rwlock_unlock: {
     event_m unlock;
 
     unlock.thread_id = row.thread_id;
-    unlock.type = event_t::lock_release;
-    unlock.object = row.arg1;
+    unlock.type = event_t::rwlock_release;
+    unlock.object = find(objects.rwlocks, row.arg1);
     unlock.distance = row.instruction_count;
 
     return unlock;
   }
+  default:
+    break;
+  }
+
+  if (row.call == call_t::pthread_create) {
+    event_m create;
+
+    create.thread_id = row.thread_id;
+    create.type = event_t::thread_create;
+    create.distance = row.instruction_count;
+    create.target_thread = target_thread;
+
+    return create;
+  }
 
-  if (row.call == "pthread_barrier_wait") {
+  if (row.call == call_t::pthread_barrier_wait) {
     event_m barrier;
 
     barrier.thread_id = row.thread_id;
     barrier.type = event_t::barrier_wait;
-    barrier.object = row.arg1;
+    barrier.object = find(objects.barriers, row.arg1);
     barrier.distance = row.instruction_count;
 
     return barrier;
   }
 
-  if (row.call == "pthread_cond_broadcast") {
+  if (row.call == call_t::pthread_cond_broadcast) {
     event_m broadcast;
 
     broadcast.thread_id = row.thread_id;
     broadcast.type = event_t::condition_broadcast;
-    broadcast.object = row.arg1;
+    broadcast.object = find(objects.condition_variables, row.arg1);
     broadcast.distance = row.instruction_count;
 
-    update_condition_variable(sm, broadcast);
-
     return broadcast;
   }
 
-  if (row.call == "pthread_cond_signal") {
+  if (row.call == call_t::pthread_cond_signal) {
     event_m signal;
 
     signal.thread_id = row.thread_id;
     signal.type = event_t::condition_signal;
-    signal.object = row.arg1;
+    signal.object = find(objects.condition_variables, row.arg1);
     signal.distance = row.instruction_count;
 
-    update_condition_variable(sm, signal);
-
     return signal;
   }
 
-  if (row.call == "pthread_cond_wait") {
+  if (row.call == call_t::pthread_cond_wait ||
+      row.call == call_t::pthread_cond_timedwait) {
     event_m wait;
 
     wait.thread_id = row.thread_id;
     wait.type = event_t::condition_wait;
-    wait.object = row.arg1;
-    wait.object2 = row.arg2;
+    wait.object = find(objects.condition_variables, row.arg1);
+    wait.object2 = find(objects.locks, row.arg2);
     wait.distance = row.instruction_count;
 
-    update_condition_variable(sm, wait);
-
     return wait;
   }
 
-  if (row.call == "thread_start") {
+  if (row.call == call_t::thread_start) {
     event_m start;
 
     start.thread_id = row.thread_id;
@@ -203,7 +224,7 @@ event_m create_event(trace_row const &row, sync_m &sm,
     return start;
   }
 
-  if (row.call == "thread_finish") {
+  if (row.call == call_t::thread_finish) {
     event_m finish;
 
     finish.thread_id = row.thread_id;
@@ -213,14 +234,13 @@ event_m create_event(trace_row const &row, sync_m &sm,
     return finish;
   }
 
-  if (row.call == "pthread_join") {
-    auto const &join_target = handles.find(row.handle);
+  if (row.call == call_t::pthread_join) {
     event_m join;
 
     join.thread_id = row.thread_id;
     join.type = event_t::thread_join;
     join.distance = row.instruction_count;
-    join.target_thread = join_target->second;
+    join.target_thread = target_thread;
 
     return join;
   }
@@ -228,12 +248,99 @@ event_m create_event(trace_row const &row, sync_m &sm,
   return event_m{};
 }
 
-app_m parse_traces(std::string const &manifest_file, sync_m &sm) {
-  zstr::ifstream manifest(manifest_file);
-  if (!manifest.good()) {
-    throw std::runtime_error("Could not load " + manifest_file);
+event_m create_event(trace_row const &row, sync_m &sm, object_tables &objects,
+                     std::map<pthread_t, thread_t> &handles,
+                     thread_t &next_create_id) {
+  if (row.call == call_t::pthread_barrier_init) {
+    add_barrier(sm, intern(objects.barriers, row.arg1), row.barrier_count);
+
+    return event_m{};
+  }
+
+  if (row.call == call_t::pthread_cond_init) {
+    add_condition_variable(sm, intern(objects.condition_variables, row.arg1));
+
+    return event_m{};
+  }
+
+  switch (row.call) {
+  case call_t::pthread_mutex_init:
+    add_lock(sm, intern(objects.locks, row.arg1));
+
+    return event_m{};
+  case call_t::pthread_spin_init:
+    add_spinlock(sm, intern(objects.locks, row.arg1));
+
+    return event_m{};
+  case call_t::pthread_rwlock_init:
+    add_rwlock(sm, intern(objects.rwlocks, row.arg1));
+
+    return event_m{};
+  default:
+    break;
   }
 
+  thread_t target_thread = INVALID_THREAD_ID;
+
+  if (row.call == call_t::pthread_create) {
+    next_create_id++;
+
+    bool was_inserted = false;
+    std::map<pthread_t, thread_t>::iterator handle;
+    std::tie(handle, was_inserted) =
+        handles.emplace(row.handle, next_create_id);
+    if (!was_inserted) {
+      // This can happen if a thread finishes and another pthread_create call
+      // occurs. For now, assume that a join call occurs before the
+      // pthread_create, so we will just overwrite the thread ID for this
+      // handle.
+      handle->second = next_create_id;
+    }
+
+    add_thread(sm, next_create_id);
+    target_thread = next_create_id;
+  } else if (row.call == call_t::pthread_join) {
+    target_thread = handles.find(row.handle)->second;
+  }
+
+  intern_objects(row, objects);
+  auto const event = to_event(row, target_thread, objects);
+
+  switch (event.type) {
+  case event_t::condition_broadcast:
+  case event_t::condition_signal:
+  case event_t::condition_wait:
+    update_condition_variable(sm, event);
+    break;
+  default:
+    break;
+  }
+
+  return event;
+}
+
+void add_row(trace_row const &row,
+             app_m &app,
+             sync_m &sm,
+             std::map<pthread_t, thread_t> &handles,
+             thread_t &next_create_id,
+             icount_t &instruction_count) {
+  auto &tm = get_thread(app, row.thread_id);
+
+  auto event = create_event(row, sm, *app.objects, handles, next_create_id);
+  if (event.type != event_t::unknown) {
+    auto const delta = row.instruction_count - instruction_count;
+    instruction_count = row.instruction_count;
+    event.distance = delta;
+
+    add_event(tm, event);
+  }
+}
+
+app_m parse_binary_trace(std::string const &file, sync_m &sm) {
+  spdlog::get("log")->info("Loading binary trace file: {}", file);
+  binary_trace const trace(file);
+
   // We need to associate pthread_t handles with thread IDs.
   std::map<pthread_t, thread_t> handles;
   thread_t next_create_id = 0;
@@ -243,39 +350,226 @@ app_m parse_traces(std::string const &manifest_file, sync_m &sm) {
 
   app_m app{};
 
-  std::string file;
-  while (manifest >> file) {
-    zstr::ifstream trace(file);
-    if (!trace.good()) {
-      throw std::runtime_error("Could not load " + file);
-    } else {
-      spdlog::get("log")->info("Loading trace file: {}", file);
+  for (std::uint64_t i = 0; i < trace.header->index_count; ++i) {
+    binary_thread const &thread = trace.threads[i];
+    icount_t instruction_count = 0;
+
+    for (std::uint64_t r = 0; r < thread.row_count; ++r) {
+      add_row(decode_row(trace, thread, r), app, sm, handles, next_create_id,
+              instruction_count);
     }
+  }
+
+  return app;
+}
+
+app_m parse_traces(std::string const &manifest_file, sync_m &sm) {
+  if (is_binary_trace(manifest_file)) {
+    return parse_binary_trace(manifest_file, sm);
+  }
+
+  // We need to associate pthread_t handles with thread IDs.
+  std::map<pthread_t, thread_t> handles;
+  thread_t next_create_id = 0;
+
+  // Add the master thread.
+  add_thread(sm, next_create_id);
+
+  app_m app{};
+
+  auto const files = read_manifest(manifest_file);
+
+  // Trace files are independent of each other until their rows are turned into events, so they are decompressed
+  // and tokenized in parallel.
+  std::vector<std::future<std::vector<trace_row>>> loaded;
+  thread_pool pool(std::min<std::size_t>(files.size(), std::thread::hardware_concurrency()));
+
+  for (auto const &file : files) {
+    loaded.push_back(pool.submit([file]() { return read_text_trace(file); }));
+  }
+
+  // Events are created in the order of the manifest so that thread IDs and synchronization objects are assigned
+  // deterministically.
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    auto const rows = loaded[i].get();
+    spdlog::get("log")->info("Loaded trace file: {}", files[i]);
 
-    std::string line;
     icount_t instruction_count = 0;
+    for (auto const &row : rows) {
+      add_row(row, app, sm, handles, next_create_id, instruction_count);
+    }
+  }
 
-    while (std::getline(trace, line) && !line.empty()) {
-      std::istringstream line_stream(line);
-      trace_row row;
+  return app;
+}
 
-      if (line_stream >> row) {
-        auto emplaced = app.threads.emplace(row.thread_id, row.thread_id);
-        auto &tm = emplaced.first->second;
+/**
+ * Run a row through the same setup as create_event without keeping the event.
+ *
+ * The threads targeted by pthread_create and pthread_join are recorded, since
+ * they depend on every row that came before in the manifest.
+ */
+void scan_row(trace_row const &row, sync_m &sm, object_tables &objects,
+              std::map<pthread_t, thread_t> &handles, thread_t &next_create_id,
+              std::deque<thread_t> &targets) {
+  auto const event = create_event(row, sm, objects, handles, next_create_id);
+
+  if (event.type == event_t::thread_create ||
+      event.type == event_t::thread_join) {
+    targets.push_back(event.target_thread);
+  }
+}
 
-        auto event = create_event(row, sm, handles, next_create_id);
-        if (event.type != event_t::unknown) {
-          auto const delta = row.instruction_count - instruction_count;
-          instruction_count = row.instruction_count;
-          event.distance = delta;
+/**
+ * Create a source that turns the rows of a single thread into events.
+ *
+ * @param read Reads the next row of the thread, returning false at the end.
+ * @param targets The threads targeted by the thread's create and join events.
+ */
+template <typename Reader>
+event_source make_source(Reader read, std::deque<thread_t> targets,
+                         std::shared_ptr<object_tables const> objects) {
+  icount_t instruction_count = 0;
+
+  return [read, targets, objects, instruction_count](event_m &event) mutable {
+    trace_row row;
 
-          add_event(tm, event);
+    while (read(row)) {
+      thread_t target_thread = INVALID_THREAD_ID;
+      if (row.call == call_t::pthread_create ||
+          row.call == call_t::pthread_join) {
+        assert(!targets.empty());
+        target_thread = targets.front();
+        targets.pop_front();
+      }
+
+      event = to_event(row, target_thread, *objects);
+      if (event.type != event_t::unknown) {
+        event.distance = row.instruction_count - instruction_count;
+        instruction_count = row.instruction_count;
+
+        return true;
+      }
+    }
+
+    return false;
+  };
+}
+
+void add_streamed_thread(app_m &app, thread_t thread_id, event_source source,
+                         std::size_t window) {
+  auto &tm = get_thread(app, thread_id);
+  if (!tm.headers.empty() || tm.source) {
+    throw std::runtime_error("Thread " + std::to_string(thread_id) +
+                             " is split across multiple trace files.");
+  }
+
+  tm.source = std::move(source);
+  tm.window = window;
+
+  refill(tm);
+}
+
+app_m stream_binary_trace(std::string const &file, sync_m &sm,
+                          std::size_t window) {
+  spdlog::get("log")->info("Scanning binary trace file: {}", file);
+  auto const trace = std::make_shared<binary_trace const>(file);
+
+  // We need to associate pthread_t handles with thread IDs.
+  std::map<pthread_t, thread_t> handles;
+  thread_t next_create_id = 0;
+
+  // Add the master thread.
+  add_thread(sm, next_create_id);
+
+  app_m app{};
+
+  for (std::uint64_t i = 0; i < trace->header->index_count; ++i) {
+    binary_thread const &thread = trace->threads[i];
+    if (thread.row_count == 0) {
+      continue;
+    }
+
+    std::deque<thread_t> targets;
+    for (std::uint64_t r = 0; r < thread.row_count; ++r) {
+      scan_row(decode_row(*trace, thread, r), sm, *app.objects, handles,
+               next_create_id, targets);
+    }
+
+    std::uint64_t cursor = 0;
+    auto read = [trace, i, cursor](trace_row &row) mutable {
+      binary_thread const &thread = trace->threads[i];
+      if (cursor == thread.row_count) {
+        return false;
+      }
+
+      row = decode_row(*trace, thread, cursor++);
+      return true;
+    };
+
+    add_streamed_thread(
+        app, thread.thread_id,
+        make_source(read, std::move(targets), app.objects), window);
+  }
+
+  return app;
+}
+
+app_m stream_traces(std::string const &manifest_file, sync_m &sm,
+                    std::size_t window) {
+  assert(window > 0);
+
+  if (is_binary_trace(manifest_file)) {
+    return stream_binary_trace(manifest_file, sm, window);
+  }
+
+  // We need to associate pthread_t handles with thread IDs.
+  std::map<pthread_t, thread_t> handles;
+  thread_t next_create_id = 0;
+
+  // Add the master thread.
+  add_thread(sm, next_create_id);
+
+  app_m app{};
+
+  for (auto const &file : read_manifest(manifest_file)) {
+    spdlog::get("log")->info("Scanning trace file: {}", file);
+
+    thread_t thread_id = INVALID_THREAD_ID;
+    std::deque<thread_t> targets;
+
+    {
+      zstr::ifstream trace(file);
+      if (!trace.good()) {
+        throw std::runtime_error("Could not load " + file);
+      }
+
+      trace_row row;
+      while (read_text_row(trace, row)) {
+        if (thread_id != INVALID_THREAD_ID && row.thread_id != thread_id) {
+          throw std::runtime_error(
+              file + " contains rows from more than one thread.");
         }
+
+        thread_id = row.thread_id;
+        scan_row(row, sm, *app.objects, handles, next_create_id, targets);
       }
     }
+
+    if (thread_id == INVALID_THREAD_ID) {
+      continue;
+    }
+
+    // The trace is reopened and read again as the thread progresses.
+    auto const trace = std::make_shared<zstr::ifstream>(file);
+    auto read = [trace](trace_row &row) { return read_text_row(*trace, row); };
+
+    add_streamed_thread(
+        app, thread_id, make_source(read, std::move(targets), app.objects),
+        window);
   }
 
   return app;
 }
 
-} // namespace rhythm
\ No newline at end of file
+} // namespace rhythm
@@ -1,6 +1,7 @@
 #ifndef RHYTHM_TRACE_HPP
 #define RHYTHM_TRACE_HPP
 
+#include <cstddef>
 #include <string>
 
 #include "application.hpp"
@@ -11,10 +12,19 @@ namespace rhythm {
 /**
  * Parse a trace and produce the resulting app_m.
  *
+ * The file is either a manifest of text trace files or a binary trace produced by rhythm-convert.
  * The sync_m will be updated with synchronization objects found in the trace.
  */
 app_m parse_traces(std::string const &file, sync_m &sm);
 
+/**
+ * Scan a trace and produce an app_m whose threads stream their events from the trace as they progress.
+ *
+ * The sync_m is set up by a first pass over the trace. Afterwards, each thread holds at most window events in
+ * memory at a time.
+ */
+app_m stream_traces(std::string const &file, sync_m &sm, std::size_t window);
+
 } // namespace rhythm
 
 #endif //RHYTHM_TRACE_HPP
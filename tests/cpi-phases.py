@@ -0,0 +1,76 @@
+import os
+import stat
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, 'scripts'))
+
+from rhythm import rhythm
+from rhythm import vtune
+
+
+def test_merged_rate_is_weighted_by_instructions():
+    slices = [
+        {'start': 0, 'instructions': 1000, 'cpi.rate': 1.0},
+        {'start': 1000, 'instructions': 3000, 'cpi.rate': 1.08},
+        {'start': 4000, 'instructions': 2000, 'cpi.rate': 2.0},
+    ]
+
+    phases = rhythm.merge_cpi_phases(slices, 0.1)
+
+    assert len(phases) == 2
+    assert phases[0]['start'] == 0
+    assert abs(phases[0]['cpi.rate'] - 1.06) < 1e-9
+    assert phases[1] == {'start': 4000, 'cpi.rate': 2.0}
+
+    # The slices themselves are left as they were.
+    assert slices[0]['cpi.rate'] == 1.0
+
+
+def test_different_rates_are_not_merged():
+    slices = [
+        {'start': 0, 'instructions': 500, 'cpi.rate': 1.0},
+        {'start': 500, 'instructions': 500, 'cpi.rate': 1.5},
+    ]
+
+    phases = rhythm.merge_cpi_phases(slices, 0.1)
+
+    assert phases == [{'start': 0, 'cpi.rate': 1.0}, {'start': 500, 'cpi.rate': 1.5}]
+
+
+# Stands in for the VTune command line, reporting a CPI rate of 1 in the first second and 2 in the next.
+FAKE_VTUNE = """#!{}
+import sys
+
+options = dict(argument.split('=', 1) for argument in sys.argv[1:] if '=' in argument)
+begin = float(options['-time-filter'].split(':')[0])
+
+if begin < 2:
+    with open(options['-report-output'], 'w') as report:
+        report.write('Thread,TID,Instructions Retired,CPI Rate\\n')
+        report.write('sh (10),10,500,3.0\\n')
+        report.write('worker (11),11,1000,{{}}\\n'.format(1.0 if begin < 1 else 2.0))
+"""
+
+
+def test_sliced_report_is_read_in_time_order():
+    with tempfile.TemporaryDirectory() as directory:
+        fake_vtune = os.path.join(directory, 'amplxe-cl')
+        with open(fake_vtune, 'w') as script:
+            script.write(FAKE_VTUNE.format(sys.executable))
+        os.chmod(fake_vtune, os.stat(fake_vtune).st_mode | stat.S_IXUSR)
+
+        # The last slice has no samples.
+        sliced_report = os.path.join(directory, 'vtune-hotspots-sliced.csv')
+        vtune.generate_sliced_report(fake_vtune, 'hotspots', directory, sliced_report, 2.5, 1.0)
+
+        phases = rhythm.read_cpi_phases(sliced_report)
+
+    assert phases == {11: {'index': "instructions", 'rates': [{'start': 0, 'cpi.rate': 1.0},
+                                                                {'start': 1000, 'cpi.rate': 2.0}]}}
+
+
+if __name__ == '__main__':
+    test_merged_rate_is_weighted_by_instructions()
+    test_different_rates_are_not_merged()
+    test_sliced_report_is_read_in_time_order()
@@ -0,0 +1,69 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "common.hpp"
+
+#ifdef __SIZEOF_INT128__
+namespace {
+
+/**
+ * @return The absolute difference between two unsigned values.
+ */
+std::uint64_t difference(std::uint64_t const a, std::uint64_t const b)
+{
+  return a > b ? a - b : b - a;
+}
+
+} // namespace
+
+int main()
+{
+  rhythm::cpi_t const cpis[] = {0.3, 0.608, 0.97, 1.21, 1.897, 3.5, 12.0};
+  rhythm::freq_t const frequencies[] = {800000000, 1200000000, 2400000000, 3700000000};
+
+  // A fixed-point rate is within 2^-33 ns of the double rate, so both paths stay within one nanosecond (or one
+  // instruction) of each other only for up to ~1e8 instructions and ~1e7 ns, which covers the distance between events.
+  rhythm::icount_t const instruction_counts[] = {0, 1, 7, 1000, 123457, 1000000, 100000000};
+  rhythm::time_t const times[] = {rhythm::time_t(0), rhythm::time_t(1), rhythm::time_t(999), rhythm::time_t(100000),
+      rhythm::time_t(1000000), rhythm::time_t(10000000)};
+
+  int failures = 0;
+
+  for(auto const cpi : cpis) {
+    for(auto const frequency : frequencies) {
+      auto const fixed_rate = rhythm::fixed_point::estimate_rate(cpi, frequency);
+      auto const double_rate = rhythm::floating_point::estimate_rate(cpi, frequency);
+
+      for(auto const instructions : instruction_counts) {
+        auto const fixed_time = rhythm::fixed_point::estimate_time(instructions, fixed_rate).count();
+        auto const double_time = rhythm::floating_point::estimate_time(instructions, double_rate).count();
+
+        if(difference(std::uint64_t(fixed_time), std::uint64_t(double_time)) > 1) {
+          std::cerr << "estimate_time(" << instructions << ") at CPI " << cpi << " and " << frequency
+                    << " Hz: fixed-point " << fixed_time << " ns, double " << double_time << " ns.\n";
+          ++failures;
+        }
+      }
+
+      for(auto const time : times) {
+        auto const fixed_instructions = rhythm::fixed_point::estimate_instructions(time, fixed_rate);
+        auto const double_instructions = rhythm::floating_point::estimate_instructions(time, double_rate);
+
+        if(difference(fixed_instructions, double_instructions) > 1) {
+          std::cerr << "estimate_instructions(" << time.count() << " ns) at CPI " << cpi << " and " << frequency
+                    << " Hz: fixed-point " << fixed_instructions << ", double " << double_instructions << ".\n";
+          ++failures;
+        }
+      }
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#else
+int main()
+{
+  // Without 128-bit integers there is no fixed-point path to compare against.
+  return EXIT_SUCCESS;
+}
+#endif